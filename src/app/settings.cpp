@@ -15,6 +15,7 @@
 #include "appcore.hpp"
 #include "fs.hpp"
 #include "gui/imguiext.hpp"
+#include "gui/socketoptions.hpp"
 #include "utils/settingsparser.hpp"
 #include "utils/uuids.hpp"
 
@@ -130,12 +131,26 @@ void Settings::load() {
     GUI::systemMenu = parser.get<bool>("gui", "systemMenu", true);
 
     OS::numThreads = parser.get<std::uint8_t>("os", "numThreads");
-    OS::queueEntries = parser.get<std::uint8_t>("os", "queueEntries", 128);
+    OS::queueEntries = parser.get<std::uint16_t>("os", "queueEntries");
+    OS::forceEpoll = parser.get<bool>("os", "forceEpoll");
+    OS::eventLoopBusyPoll = parser.get<std::uint32_t>("os", "eventLoopBusyPoll");
     OS::bluetoothUUIDs = parser.get<std::vector<std::pair<std::string, UUIDs::UUID128>>>("os", "bluetoothUUIDs",
         {
             { "L2CAP", UUIDs::createFromBase(0x0100) },
             { "RFCOMM", UUIDs::createFromBase(0x0003) },
         });
+
+    OS::socketOptions = {
+        .fastOpen = parser.get<bool>("os", "tcpFastOpen"),
+        .deferAccept = parser.get<bool>("os", "tcpDeferAccept"),
+        .noDelay = parser.get<bool>("os", "tcpNoDelay"),
+        .quickAck = parser.get<bool>("os", "tcpQuickAck"),
+        .recvBufSize = parser.get<std::uint32_t>("os", "recvBufSize"),
+        .sendBufSize = parser.get<std::uint32_t>("os", "sendBufSize"),
+        .busyPoll = parser.get<std::uint32_t>("os", "socketBusyPoll"),
+        .maxPacingRate = parser.get<std::uint32_t>("os", "maxPacingRate"),
+        .timestamps = parser.get<bool>("os", "timestamps"),
+    };
 }
 
 void Settings::save() {
@@ -187,9 +202,24 @@ void Settings::drawSettingsWindow(bool& open) {
 
     ImGui::SetNextItemWidth(4_fh);
     ImGuiExt::inputScalar("io_uring queue entries (Linux only)", OS::queueEntries);
+    ImGui::SameLine();
+    ImGui::Text("(0 to size automatically)");
+
+    ImGui::Checkbox("Use epoll instead of io_uring (Linux only)", &OS::forceEpoll);
+    ImGuiExt::helpMarker("epoll is also used automatically if io_uring is not available.");
+
+    ImGui::SetNextItemWidth(4_fh);
+    ImGuiExt::inputScalar("Event loop busy poll (microseconds, Linux only)", OS::eventLoopBusyPoll);
+    ImGuiExt::helpMarker("Time for event loops to poll for completions before sleeping, which lowers latency at the "
+                         "cost of CPU time. Network devices are also busy polled on kernel 6.9 and later. "
+                         "0 to disable.");
 
     drawBluetoothUUIDsSettings(OS::bluetoothUUIDs);
 
+    ImGui::Spacing();
+    ImGui::Text("Default socket options (can be changed when creating connections and servers)");
+    drawSocketOptions(OS::socketOptions, true, true, true);
+
     // ========================= Actions =========================
     ImGui::Dummy({ 0, 1_fh });
     if (ImGui::Button("Discard Changes")) open = false;
@@ -206,8 +236,21 @@ void Settings::drawSettingsWindow(bool& open) {
 
         parser.set("os", "numThreads", OS::numThreads);
         parser.set("os", "queueEntries", OS::queueEntries);
+        parser.set("os", "forceEpoll", OS::forceEpoll);
+        parser.set("os", "eventLoopBusyPoll", OS::eventLoopBusyPoll);
         parser.set("os", "bluetoothUUIDs", OS::bluetoothUUIDs);
 
+        const auto& opts = OS::socketOptions;
+        parser.set("os", "tcpFastOpen", opts.fastOpen);
+        parser.set("os", "tcpDeferAccept", opts.deferAccept);
+        parser.set("os", "tcpNoDelay", opts.noDelay);
+        parser.set("os", "tcpQuickAck", opts.quickAck);
+        parser.set("os", "recvBufSize", opts.recvBufSize);
+        parser.set("os", "sendBufSize", opts.sendBufSize);
+        parser.set("os", "socketBusyPoll", opts.busyPoll);
+        parser.set("os", "maxPacingRate", opts.maxPacingRate);
+        parser.set("os", "timestamps", opts.timestamps);
+
         AppCore::configOnNextFrame();
     }
 
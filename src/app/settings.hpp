@@ -8,6 +8,7 @@
 
 #include <imgui.h>
 
+#include "sockets/delegates/delegates.hpp"
 #include "utils/uuids.hpp"
 
 namespace Settings {
@@ -27,8 +28,11 @@ namespace Settings {
 
     namespace OS {
         inline std::uint8_t numThreads;
-        inline std::uint8_t queueEntries;
+        inline std::uint16_t queueEntries; // 0 to size automatically
+        inline bool forceEpoll; // Use epoll even if io_uring is available (Linux only)
+        inline std::uint32_t eventLoopBusyPoll; // Microseconds to poll before sleeping, 0 to disable (Linux only)
         inline std::vector<std::pair<std::string, UUIDs::UUID128>> bluetoothUUIDs;
+        inline SocketOptions socketOptions; // Defaults for new Internet Protocol sockets
     }
 
     // Loads the application settings.
@@ -0,0 +1,68 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Packet capture is only implemented on Linux
+#if OS_LINUX
+#include "capturewindow.hpp"
+
+#include <format>
+#include <string_view>
+#include <utility>
+
+#include <imgui.h>
+
+#include "gui/imguiext.hpp"
+#include "os/error.hpp"
+
+CaptureWindow::CaptureWindow(std::string_view title, const CaptureFilter& filter) : Window(title) {
+    spawn(withCancellation(ioCancel.getToken(), start(filter)));
+}
+
+CaptureWindow::~CaptureWindow() {
+    ioCancel.cancel();
+}
+
+Task<> CaptureWindow::start(CaptureFilter filter) try {
+    auto program = co_await makeFilter(std::move(filter));
+    capture.emplace(program);
+    console.addInfo("Capture started.");
+} catch (const System::SystemError& error) {
+    console.addError(error.what());
+}
+
+Task<> CaptureWindow::read() try {
+    pendingRead = true;
+
+    co_await capture->read([this](const CapturedPacket& packet) {
+        // Packets sent by this host are shown in blue, received packets in green
+        ImVec4 color = packet.outgoing ? ImVec4{ 0, 0.5f, 1, 1 } : ImVec4{ 0.13f, 0.55f, 0.13f, 1 };
+        auto headers = std::format("{} ({} bytes)", formatPacketHeaders(packet.data), packet.length);
+        console.addMessage(headers, packet.outgoing ? "OUT" : "IN ", color, packet.timestamp);
+
+        auto payload = getPacketPayload(packet.data);
+        std::string_view payloadText{ reinterpret_cast<const char*>(payload.data()), payload.size() };
+        if (!payload.empty()) console.addText(payloadText, "", {}, true, "", packet.timestamp);
+    });
+
+    pendingRead = false;
+} catch (const System::SystemError& error) {
+    if (!error.isCanceled()) console.addError(error.what());
+}
+
+void CaptureWindow::onBeforeUpdate() {
+    using namespace ImGuiExt::Literals;
+
+    ImGui::SetNextWindowSize(45_fh * 20_fh, ImGuiCond_Appearing);
+    if (capture && !pendingRead) spawn(withCancellation(ioCancel.getToken(), read()));
+}
+
+void CaptureWindow::onUpdate() {
+    if (capture) {
+        const CaptureStats& stats = capture->getStats();
+        ImGui::Text("Packets: %llu captured, %llu dropped", static_cast<unsigned long long>(stats.packets),
+            static_cast<unsigned long long>(stats.drops));
+    }
+
+    console.update("output");
+}
+#endif
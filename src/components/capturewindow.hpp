@@ -0,0 +1,36 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include "console.hpp"
+#include "window.hpp"
+#include "net/capture.hpp"
+#include "utils/cancellation.hpp"
+#include "utils/task.hpp"
+
+// Shows the packets of a connection in a GUI window (Linux only).
+class CaptureWindow : public Window {
+    std::optional<PacketCapture> capture; // Empty if the capture could not be started
+    Console console;
+    bool pendingRead = false;
+    CancelSource ioCancel; // Stops starting and reading the capture when the window is closed
+
+    // Builds the capture filter, then starts the capture.
+    Task<> start(CaptureFilter filter);
+
+    // Reads the next packets and adds them to the console.
+    Task<> read();
+
+    void onBeforeUpdate() override;
+
+    void onUpdate() override;
+
+public:
+    CaptureWindow(std::string_view title, const CaptureFilter& filter);
+
+    ~CaptureWindow() override;
+};
@@ -3,6 +3,7 @@
 
 #include "connwindow.hpp"
 
+#include <cstdint>
 #include <format>
 #include <memory>
 #include <string>
@@ -34,19 +35,27 @@ SocketPtr makeClientSocket(bool useTLS, ConnectionType type) {
         case L2CAP:
         case RFCOMM:
             return std::make_unique<ClientSocketBT>();
+#if !OS_WINDOWS
+        case UnixStream:
+        case UnixSeqPacket:
+            return std::make_unique<ClientSocketUnix>();
+#endif
         default:
             std::unreachable();
     }
 }
 
-ConnWindow::ConnWindow(std::string_view title, bool useTLS, const Device& device, std::string_view) :
-    Window(title), socket(makeClientSocket(useTLS, device.type)) {
+ConnWindow::ConnWindow(std::string_view title, bool useTLS, const Device& device, std::string_view,
+    const SocketOptions& options) :
+    Window(title), socket(makeClientSocket(useTLS, device.type)), canSendFiles(isStreamType(device.type)) {
     if (Settings::GUI::systemMenu) Menu::addWindowMenuItem(getTitle());
-    connect(device);
+    socket->setOptions(options);
+    spawn(withCancellation(ioCancel.getToken(), connect(device)));
 }
 
 ConnWindow::~ConnWindow() {
     if (Settings::GUI::systemMenu) Menu::removeWindowMenuItem(getTitle());
+    ioCancel.cancel();
     socket->cancelIO();
 }
 
@@ -57,6 +66,9 @@ Task<> ConnWindow::connect(Device device) try {
 
     console.addInfo("Connected.");
     connected = true;
+
+    // Received data is read for the lifetime of the connection by one coroutine
+    spawn(withCancellation(ioCancel.getToken(), readHandler()));
 } catch (const System::SystemError& error) {
     console.errorHandler(error);
 } catch (const Botan::TLS::TLS_Exception& error) {
@@ -64,7 +76,9 @@ Task<> ConnWindow::connect(Device device) try {
 }
 
 Task<> ConnWindow::sendHandler(std::string s) try {
-    co_await socket->send(s);
+    // The text is echoed once it is sent, so its timestamp is the time it was transmitted
+    std::uint64_t timestamp = co_await socket->sendTimestamped(s);
+    console.addSent(s, timestamp);
 } catch (const System::SystemError& error) {
     console.errorHandler(error);
 } catch (const Botan::TLS::TLS_Exception& error) {
@@ -72,33 +86,40 @@ Task<> ConnWindow::sendHandler(std::string s) try {
 }
 
 Task<> ConnWindow::readHandler() try {
-    if (!connected || pendingRecv) co_return;
-    pendingRecv = true;
-
-    auto [complete, closed, data, alert] = co_await socket->recv(console.getRecvSize());
-
-    if (complete) {
-        if (closed) {
-            // Peer closed connection
-            console.addInfo("Remote host closed connection.");
-            socket->close();
-            connected = false;
-        } else {
-            console.addText(data);
+    auto stream = socket->recvStream(console.getRecvSize());
+
+    while (auto result = co_await stream.next()) {
+        if (!*result) {
+            console.errorHandler(result->error());
+            co_return;
         }
-    }
 
-    if (alert) {
-        std::string desc = "ALERT";
-        ImVec4 color{ 0, 0.6f, 0, 1 };
-        if (alert->isFatal) {
-            console.addMessage(std::format("FATAL: {}", alert->desc), desc, color);
-            connected = false;
-        } else {
+        auto& [complete, closed, data, alert, timestamp] = **result;
+
+        if (complete) {
+            if (closed) {
+                // Peer closed connection
+                console.addInfo("Remote host closed connection.");
+                socket->close();
+                connected = false;
+                co_return;
+            }
+
+            console.addText(data, "", {}, true, "", timestamp);
+        }
+
+        if (alert) {
+            std::string desc = "ALERT";
+            ImVec4 color{ 0, 0.6f, 0, 1 };
+            if (alert->isFatal) {
+                console.addMessage(std::format("FATAL: {}", alert->desc), desc, color);
+                connected = false;
+                co_return;
+            }
+
             console.addMessage(alert->desc, desc, color);
         }
     }
-    pendingRecv = false;
 } catch (const System::SystemError& error) {
     console.errorHandler(error);
 } catch (const Botan::TLS::TLS_Exception& error) {
@@ -109,9 +130,14 @@ void ConnWindow::onBeforeUpdate() {
     using namespace ImGuiExt::Literals;
 
     ImGui::SetNextWindowSize(35_fh * 20_fh, ImGuiCond_Appearing);
-    readHandler();
 }
 
 void ConnWindow::onUpdate() {
-    if (auto sendString = console.updateWithTextbox()) sendHandler(*sendString);
+    if (canSendFiles) {
+        ImGui::BeginDisabled(!connected);
+        if (fileSender.update()) spawn(fileSender.send({ socket }, console));
+        ImGui::EndDisabled();
+    }
+
+    if (auto sendString = console.updateWithTextbox()) spawn(sendHandler(*sendString));
 }
@@ -3,21 +3,26 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <string_view>
 
+#include "filesender.hpp"
 #include "ioconsole.hpp"
 #include "window.hpp"
 #include "net/device.hpp"
 #include "sockets/delegates/delegates.hpp"
+#include "utils/cancellation.hpp"
 #include "utils/task.hpp"
 
 // Handles a socket connection in a GUI window.
 class ConnWindow : public Window {
-    SocketPtr socket; // Internal socket
+    std::shared_ptr<Socket> socket; // Internal socket, shared with file sends while they send a chunk
     IOConsole console;
+    FileSender fileSender;
     bool connected = false;
-    bool pendingRecv = false;
+    bool canSendFiles; // If the connection is a stream that files can be sent through
+    CancelSource ioCancel; // Stops connecting and receiving when the window is closed
 
     // Connects to the server.
     Task<> connect(Device device);
@@ -25,7 +30,7 @@ class ConnWindow : public Window {
     // Sends a string through the socket.
     Task<> sendHandler(std::string s);
 
-    // Receives a string from the socket and displays it in the console output.
+    // Receives strings from the socket until the connection ends, and displays them in the console output.
     Task<> readHandler();
 
     // Handles incoming I/O.
@@ -34,7 +39,8 @@ class ConnWindow : public Window {
     void onUpdate() override;
 
 public:
-    ConnWindow(std::string_view title, bool useTLS, const Device& device, std::string_view);
+    ConnWindow(std::string_view title, bool useTLS, const Device& device, std::string_view,
+        const SocketOptions& options);
 
     ~ConnWindow() override;
 };
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <ctime>
 #include <format>
 #include <iterator>
@@ -27,25 +28,28 @@ bool colorsEqual(const ImVec4& a, const ImVec4& b) {
     return floatsEqual(a.x, b.x) && floatsEqual(a.y, b.y) && floatsEqual(a.z, b.z) && floatsEqual(a.w, b.w);
 }
 
-std::string getTimestamp() {
+std::string getTimestamp(std::uint64_t timestamp) {
     // Adapted from https://stackoverflow.com/a/35157784
     using namespace std::chrono;
     using namespace std::literals;
 
-    auto now = system_clock::now();
+    // Use the current time if there is no timestamp
+    auto sinceEpoch = duration_cast<system_clock::duration>(nanoseconds{ timestamp });
+    auto time = timestamp == 0 ? system_clock::now() : system_clock::time_point{ sinceEpoch };
 
-    // Get milliseconds (remainder from division into seconds)
-    auto ms = (duration_cast<milliseconds>(now.time_since_epoch()) % 1s).count();
+    // Get microseconds (remainder from division into seconds), kernel timestamps are precise enough to show them
+    auto us = (duration_cast<microseconds>(time.time_since_epoch()) % 1s).count();
 
-    // Get local time from current time point
-    auto timer = system_clock::to_time_t(now);
+    // Get local time from the time point
+    auto timer = system_clock::to_time_t(time);
     auto local = *std::localtime(&timer);
 
     // Return formatted string
-    return std::format("{:02}:{:02}:{:02}.{:03}", local.tm_hour, local.tm_min, local.tm_sec, ms);
+    return std::format("{:02}:{:02}:{:02}.{:06}", local.tm_hour, local.tm_min, local.tm_sec, us);
 }
 
-void Console::add(std::string_view s, const ImVec4& color, bool canUseHex, std::string_view hoverText) {
+void Console::add(std::string_view s, const ImVec4& color, bool canUseHex, std::string_view hoverText,
+    std::uint64_t timestamp) {
     // Avoid empty strings
     if (s.empty()) return;
 
@@ -53,7 +57,7 @@ void Console::add(std::string_view s, const ImVec4& color, bool canUseHex, std::
 
     // Determine if text goes on a new line
     if (items.empty() || items.back().text.ends_with('\n') || !colorsEqual(items.back().color, color))
-        items.emplace_back(canUseHex, "", "", color, getTimestamp(), hoverTextOpt);
+        items.emplace_back(canUseHex, "", "", color, getTimestamp(timestamp), hoverTextOpt);
 
     // Add text, fix invalid UTF-8 if necessary
     utf8::replace_invalid(s.begin(), s.end(), std::back_inserter(items.back().text));
@@ -74,8 +78,8 @@ void Console::drawTimestamps() {
     // The timestamps child window is shorter by ScrollbarSize to align with main content
     const float height = -ImGui::GetFrameHeightWithSpacing() - style.ScrollbarSize;
 
-    // Calculate the width of the timestamps (always 12 chars) using the width of the "0" character
-    ImVec2 size{ ImGui::CalcTextSize("0").x * 12, height };
+    // Calculate the width of the timestamps (always 15 chars) using the width of the "0" character
+    ImVec2 size{ ImGui::CalcTextSize("0").x * 15, height };
     ImGuiWindowFlags flags = ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse;
 
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, { 0, style.WindowPadding.y });
@@ -182,13 +186,13 @@ void Console::update(std::string_view id) {
 }
 
 void Console::addText(std::string_view s, std::string_view pre, const ImVec4& color, bool canUseHex,
-    std::string_view hoverText) {
+    std::string_view hoverText, std::uint64_t timestamp) {
     // Split the string by newlines to get each line, then add each line
     for (auto start = s.begin(), end = start; end != s.end(); start = end) {
         end = std::find(start, s.end(), '\n'); // Find the next newline
 
         // Get substring
         if (end != s.end()) end++; // Increment end to include the newline in the substring
-        add(std::string{ pre } + std::string{ start, end }, color, canUseHex, hoverText);
+        add(std::string{ pre } + std::string{ start, end }, color, canUseHex, hoverText, timestamp);
     }
 }
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <format>
 #include <functional>
 #include <optional>
@@ -50,7 +51,8 @@ class Console {
     }
 
     // Adds text to the console. Does not make it go on its own line.
-    void add(std::string_view s, const ImVec4& color, bool canUseHex, std::string_view hoverText);
+    void add(std::string_view s, const ImVec4& color, bool canUseHex, std::string_view hoverText,
+        std::uint64_t timestamp);
 
     // Draws the timestamps to the left of the content.
     void drawTimestamps();
@@ -79,13 +81,14 @@ public:
     // Adds text to the console. Accepts multiline strings.
     // The color of the text can be set, as well as an optional string to show before each line.
     // If canUseHex is set to false, the text will never be displayed as hexadecimal.
+    // The timestamp is the time the text was sent or received in nanoseconds since the Unix epoch, or 0 for now.
     void addText(std::string_view s, std::string_view pre = "", const ImVec4& color = {}, bool canUseHex = true,
-        std::string_view hoverText = "");
+        std::string_view hoverText = "", std::uint64_t timestamp = 0);
 
     // Adds a message with a given color and description.
-    void addMessage(std::string_view s, std::string_view desc, const ImVec4& color) {
+    void addMessage(std::string_view s, std::string_view desc, const ImVec4& color, std::uint64_t timestamp = 0) {
         forceNextLine();
-        addText(s, std::format("[{}] ", desc), color, false);
+        addText(s, std::format("[{}] ", desc), color, false, "", timestamp);
         forceNextLine();
     }
 
@@ -0,0 +1,134 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "filesender.hpp"
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <botan/tls_exceptn.h>
+#include <imgui.h>
+
+#include "gui/imguiext.hpp"
+#include "os/async.hpp"
+#include "os/error.hpp"
+
+// Number of bytes sent to each socket before the progress is updated
+constexpr std::size_t chunkSize = 1024 * 1024;
+
+// Converts a number of bytes to mebibytes.
+double toMiB(std::uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024 * 1024);
+}
+
+bool FileSender::update() {
+    using namespace ImGuiExt::Literals;
+
+    if (sending) {
+        double elapsed = ImGui::GetTime() - startTime;
+        float fraction = fileSize == 0 ? 1 : static_cast<float>(bytesSent) / static_cast<float>(fileSize);
+        std::string overlay = std::format("{:.1f} / {:.1f} MiB", toMiB(bytesSent), toMiB(fileSize));
+
+        ImGui::ProgressBar(fraction, { 20_fh, 0 }, overlay.c_str());
+        ImGui::SameLine();
+        ImGui::Text("%.1f MiB/s", elapsed > 0 ? toMiB(bytesSent) / elapsed : 0);
+
+        ImGui::SameLine();
+        ImGui::BeginDisabled(stopRequested);
+        if (ImGui::Button("Stop")) stopRequested = true;
+        ImGui::EndDisabled();
+        return false;
+    }
+
+    ImGui::SetNextItemWidth(20_fh);
+    ImGuiExt::inputText("##filePath", path);
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(path.empty());
+    bool clicked = ImGui::Button("Send File");
+    ImGui::EndDisabled();
+    return clicked;
+}
+
+Task<> FileSender::send(std::vector<std::weak_ptr<const Socket>> sockets, IOConsole& console) try {
+    if (sending) co_return;
+
+    std::error_code ec;
+    fileSize = std::filesystem::file_size(path, ec);
+    if (ec) {
+        console.addError(std::format("Could not open {}: {}", path, ec.message()));
+        co_return;
+    }
+
+    sending = true;
+    stopRequested = false;
+    bytesSent = 0;
+    startTime = ImGui::GetTime();
+    co_await file.open(path, Async::FileMode::Read);
+
+    // Progress of each socket, since sends can end at different points
+    struct Target {
+        std::weak_ptr<const Socket> socket;
+        std::uint64_t sent = 0;
+        bool finished = false;
+        bool dropped = false; // If the socket was destroyed or failed, so it no longer counts towards the progress
+    };
+
+    std::vector<Target> targets;
+    for (auto& i : sockets) targets.push_back({ std::move(i) });
+
+    // Each chunk goes to every socket before the next one is read
+    bool remaining = true;
+    while (!stopRequested && remaining) {
+        remaining = false;
+        for (auto& target : targets) {
+            if (target.finished) continue;
+
+            // Sockets of removed or reconnected clients are dropped
+            auto socket = target.socket.lock();
+            if (!socket) {
+                target.dropped = true;
+                continue;
+            }
+
+            try {
+                std::size_t chunkSent
+                    = co_await socket->sendFile(file, static_cast<std::int64_t>(target.sent), chunkSize);
+                target.sent += chunkSent;
+                target.finished = chunkSent == 0 || target.sent >= fileSize;
+            } catch (const System::SystemError& error) {
+                console.errorHandler(error);
+                target.dropped = true;
+                continue;
+            }
+
+            remaining |= !target.finished;
+        }
+
+        std::erase_if(targets, [](const Target& target) { return target.dropped; });
+
+        auto least = std::ranges::min_element(targets, {}, &Target::sent);
+        if (least != targets.end()) bytesSent = least->sent;
+    }
+
+    co_await file.close();
+    sending = false;
+
+    std::string_view status = stopRequested ? "Stopped sending" : "Sent";
+    console.addInfo(std::format("{} {} of {} bytes from {}.", status, bytesSent, fileSize, path));
+} catch (const System::SystemError& error) {
+    sending = false;
+    console.errorHandler(error);
+} catch (const Botan::TLS::TLS_Exception& error) {
+    sending = false;
+    console.addError(error.what());
+}
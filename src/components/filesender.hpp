@@ -0,0 +1,35 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ioconsole.hpp"
+#include "os/file.hpp"
+#include "sockets/socket.hpp"
+#include "utils/task.hpp"
+
+// Streams a file to sockets in chunks, showing the progress and throughput.
+class FileSender {
+    std::string path; // Path of the file to send
+    File file; // File being sent
+    bool sending = false;
+    bool stopRequested = false; // If sending stops after the current chunk
+    std::uint64_t fileSize = 0;
+    std::uint64_t bytesSent = 0; // Bytes of the file sent to every socket (the least sent to any one socket)
+    double startTime = 0; // Time when sending started, in seconds
+
+public:
+    // Draws the file path and send button, or the progress while a file is being sent.
+    // Returns true when a file should be sent.
+    bool update();
+
+    // Sends the chosen file to each socket, one chunk at a time. Messages and errors are added to a console.
+    // Sockets are only kept alive while a chunk is sent to them. A socket that is destroyed or fails in between is
+    // dropped, and the file continues to the others.
+    Task<> send(std::vector<std::weak_ptr<const Socket>> sockets, IOConsole& console);
+};
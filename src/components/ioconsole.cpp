@@ -76,12 +76,8 @@ std::optional<std::string> IOConsole::updateWithTextbox() {
         // Add a final line ending if set
         if (addFinalLineEnding) sendString += selectedEnding;
 
-        // Invoke the callback function if the string is not empty
-        if (!sendString.empty()) {
-            if (sendEchoing) addMessage(sendString, "SENT ", { 0.28f, 0.67f, 0.68f, 1 });
-
-            ret = sendString;
-        }
+        // Return the string if it is not empty, it is echoed by the caller with addSent()
+        if (!sendString.empty()) ret = sendString;
 
         // Blank out input textbox
         if (clearTextboxOnSubmit) textBuf.clear();
@@ -100,3 +96,7 @@ void IOConsole::errorHandler(System::SystemError error) {
     // Don't handle errors caused by I/O cancellation
     if (error && !error.isCanceled()) addError(error.what());
 }
+
+void IOConsole::errorHandler(const System::Error& error) {
+    if (error && !error.isCanceled()) addError(error.format());
+}
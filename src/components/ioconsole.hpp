@@ -3,8 +3,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 
 #include <imgui.h>
 
@@ -31,10 +33,19 @@ public:
     // Draws the window contents and returns text entered into the textbox when Enter is pressed.
     std::optional<std::string> updateWithTextbox();
 
+    // Adds text that was sent to the output if send echoing is enabled.
+    // The timestamp is the time the text was transmitted in nanoseconds since the Unix epoch, or 0 for now.
+    void addSent(std::string_view s, std::uint64_t timestamp = 0) {
+        if (sendEchoing) addMessage(s, "SENT ", { 0.28f, 0.67f, 0.68f, 1 }, timestamp);
+    }
+
     unsigned int getRecvSize() {
         return recvSize;
     }
 
     // Prints the details of a thrown exception.
     void errorHandler(System::SystemError error);
+
+    // Prints the details of a returned error, formatting it only if it is shown.
+    void errorHandler(const System::Error& error);
 };
@@ -0,0 +1,51 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "relaywindow.hpp"
+
+#include <format>
+#include <string_view>
+
+#include <imgui.h>
+
+#include "net/enums.hpp"
+#include "os/error.hpp"
+
+RelayWindow::RelayWindow(std::string_view title, const Device& serverInfo, const Device& target,
+    const SocketOptions& options) : Window(title) {
+    try {
+        relay.emplace(serverInfo, target, options, [this](std::string_view message, bool isError) {
+            if (isError) console.addError(message);
+            else console.addInfo(message);
+        });
+    } catch (const System::SystemError& error) {
+        console.addError(error.what());
+        setTitle(std::format("Invalid Relay##{}", ImGui::GetTime()));
+        return;
+    }
+
+    auto [port, ip] = relay->getAddress();
+    setTitle(std::format("TCP ({}) Relay - port {} to {}|{}##{}", getIPTypeName(ip), port, target.address, target.port,
+        serverInfo.address));
+    console.addInfo(std::format("Relay is active on port {}, forwarding to {} on port {}.", port, target.address,
+        target.port));
+}
+
+void RelayWindow::onBeforeUpdate() {
+    if (relay) relay->update();
+}
+
+void RelayWindow::onUpdate() {
+    if (relay) {
+        const RelayStats& stats = relay->getStats();
+
+        ImGui::Text("Mode: %s", relay->usesSplice() ? "splice (zero-copy)" : "copy");
+        ImGui::Text("Clients: %llu active, %llu accepted", static_cast<unsigned long long>(stats.active),
+            static_cast<unsigned long long>(stats.accepted));
+        ImGui::Text("Bytes to target: %llu", static_cast<unsigned long long>(stats.toTarget));
+        ImGui::Text("Bytes to clients: %llu", static_cast<unsigned long long>(stats.toClients));
+        ImGui::Separator();
+    }
+
+    console.update("output");
+}
@@ -0,0 +1,26 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include "console.hpp"
+#include "window.hpp"
+#include "net/device.hpp"
+#include "net/relay.hpp"
+#include "sockets/delegates/delegates.hpp"
+
+// Handles a TCP relay in a GUI window.
+class RelayWindow : public Window {
+    std::optional<Relay> relay; // Empty if the relay could not be started
+    Console console;
+
+    void onBeforeUpdate() override;
+
+    void onUpdate() override;
+
+public:
+    RelayWindow(std::string_view title, const Device& serverInfo, const Device& target, const SocketOptions& options);
+};
@@ -3,11 +3,10 @@
 
 #include "sdpwindow.hpp"
 
-#include <chrono>
 #include <format>
-#include <future>
 #include <string_view>
 #include <system_error>
+#include <utility>
 #include <variant>
 
 #include <imgui.h>
@@ -16,6 +15,7 @@
 #include "gui/imguiext.hpp"
 #include "gui/newconn.hpp"
 #include "net/btutils.hpp"
+#include "os/offload.hpp"
 #include "utils/overload.hpp"
 #include "utils/uuids.hpp"
 
@@ -83,25 +83,33 @@ void SDPWindow::drawConnOptions(std::string_view info) {
     if (ImGui::Button("Connect")) addConnWindow(list, false, { connType, target.name, target.address, connPort }, info);
 }
 
+SDPWindow::~SDPWindow() {
+    inquiryCancel.cancel();
+}
+
+Task<> SDPWindow::runInquiry(UUIDs::UUID128 uuid) {
+    sdpInquiry = RunningInquiry{};
+
+    try {
+        auto results = co_await Async::offload([address = target.address, uuid, flushCache = flushCache] {
+            return BTUtils::sdpLookup(address, uuid, flushCache);
+        });
+        sdpInquiry = std::move(results);
+    } catch (const System::SystemError& error) {
+        sdpInquiry = error;
+    } catch (const std::system_error& error) {
+        sdpInquiry = error;
+    }
+}
+
 void SDPWindow::checkInquiryStatus() {
     Overload visitor{
         [](std::monostate) { ImGui::TextUnformatted("No inquiry run"); },
-        [this](AsyncSDPInquiry& asyncInq) {
-            using namespace std::literals;
-            if (asyncInq.wait_for(0s) != std::future_status::ready) {
-                // Running, display a spinner
-                ImGui::TextUnformatted("Running SDP inquiry");
-                ImGui::SameLine();
-                ImGuiExt::spinner();
-                return;
-            }
-
-            // The async operation has completed, attempt to get its results
-            try {
-                sdpInquiry = asyncInq.get();
-            } catch (const System::SystemError& error) {
-                sdpInquiry = error;
-            }
+        [](RunningInquiry) {
+            // Running, display a spinner
+            ImGui::TextUnformatted("Running SDP inquiry");
+            ImGui::SameLine();
+            ImGuiExt::spinner();
         },
         [](const std::system_error&) { ImGui::TextWrapped("System error: Failed to launch thread."); },
         [](const System::SystemError& error) { ImGui::TextWrapped("Error %s", error.what()); },
@@ -128,7 +136,7 @@ void SDPWindow::drawSDPTab() {
     if (!ImGui::BeginTabItem("Connect with SDP")) return;
 
     // Disable the widgets if the async inquiry is running
-    ImGui::BeginDisabled(std::holds_alternative<AsyncSDPInquiry>(sdpInquiry));
+    ImGui::BeginDisabled(std::holds_alternative<RunningInquiry>(sdpInquiry));
 
     // UUID selection combobox
     using namespace ImGuiExt::Literals;
@@ -154,15 +162,8 @@ void SDPWindow::drawSDPTab() {
     }
 
     // Run button
-    if (ImGui::Button("Run SDP Inquiry")) {
-        try {
-            // Start the inquiry
-            sdpInquiry = std::async(std::launch::async, BTUtils::sdpLookup, target.address, uuids[selectedUUID].second,
-                flushCache);
-        } catch (const std::system_error& error) {
-            sdpInquiry = error;
-        }
-    }
+    if (ImGui::Button("Run SDP Inquiry"))
+        spawn(withCancellation(inquiryCancel.getToken(), runInquiry(uuids[selectedUUID].second)));
 
     ImGui::EndDisabled();
     checkInquiryStatus();
@@ -184,7 +185,7 @@ void SDPWindow::onBeforeUpdate() {
     using namespace ImGuiExt::Literals;
 
     ImGui::SetNextWindowSize(30_fh * 18_fh, ImGuiCond_Appearing);
-    setClosable(!std::holds_alternative<AsyncSDPInquiry>(sdpInquiry));
+    setClosable(!std::holds_alternative<RunningInquiry>(sdpInquiry));
 }
 
 void SDPWindow::onUpdate() {
@@ -3,7 +3,6 @@
 
 #pragma once
 
-#include <future>
 #include <string>
 #include <string_view>
 #include <system_error>
@@ -15,10 +14,13 @@
 #include "net/device.hpp"
 #include "net/enums.hpp"
 #include "os/error.hpp"
+#include "utils/cancellation.hpp"
+#include "utils/task.hpp"
+#include "utils/uuids.hpp"
 
 // Handles an SDP inquiry in a GUI window.
 class SDPWindow : public Window {
-    using AsyncSDPInquiry = std::future<std::vector<BTUtils::SDPResult>>; // Results of an SDP search
+    struct RunningInquiry {}; // Placeholder for an inquiry running on the offload threads
 
     Device target; // Target to perform SDP inquiries on and connect to
 
@@ -38,12 +40,16 @@ class SDPWindow : public Window {
     // The value this variant currently holds contains data about the SDP inquiry.
     // The type of the value represents the inquiry's state.
     std::variant<std::monostate, // Default value when no inquiries have been run yet
-        AsyncSDPInquiry, // Future object corresponding to an in-progress inquiry
-        std::system_error, // Error when the asynchronous thread couldn't be created
+        RunningInquiry, // Value while an inquiry is in progress
+        std::system_error, // Error when the offload thread couldn't be created
         System::SystemError, // Error that occurred during an in-progress inquiry
         std::vector<BTUtils::SDPResult> // The results of the inquiry when it has completed
         >
         sdpInquiry;
+    CancelSource inquiryCancel; // Stops waiting for the inquiry when the window is closed
+
+    // Runs an SDP inquiry without blocking the GUI and stores its results.
+    Task<> runInquiry(UUIDs::UUID128 uuid);
 
     // Draws the entries from an SDP lookup with buttons to connect to each in a tree format.
     bool drawSDPList(const std::vector<BTUtils::SDPResult>& list);
@@ -70,4 +76,6 @@ public:
     // Sets the information needed to create connections.
     SDPWindow(std::string_view title, const Device& target, WindowList& list) :
         Window(title), target(target), list(list) {}
+
+    ~SDPWindow() override;
 };
@@ -4,10 +4,14 @@
 #include "serverwindow.hpp"
 
 #include <array>
+#include <cstdint>
+#include <exception>
 #include <format>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -16,6 +20,7 @@
 #include "gui/imguiext.hpp"
 #include "gui/menu.hpp"
 #include "net/enums.hpp"
+#include "os/combinators.hpp"
 #include "os/error.hpp"
 #include "sockets/delegates/delegates.hpp"
 #include "sockets/serversocket.hpp"
@@ -34,6 +39,9 @@ SocketPtr makeServerSocket(ConnectionType type) {
 
     if (type == None) std::unreachable();
     if (type == TCP || type == UDP) return std::make_unique<ServerSocket<SocketTag::IP>>();
+#if !OS_WINDOWS
+    if (type == UnixStream || type == UnixSeqPacket) return std::make_unique<ServerSocket<SocketTag::Unix>>();
+#endif
     return std::make_unique<ServerSocket<SocketTag::BT>>();
 }
 
@@ -41,28 +49,35 @@ std::string formatDevice(const Device& device) {
     return std::format("{}|{}", device.name.empty() ? device.address : device.name, device.port);
 }
 
-Task<> ServerWindow::Client::recv(IOConsole& serverConsole, const Device& device, unsigned int size) try {
-    if (!connected || pendingRecv) co_return;
-    pendingRecv = true;
+Task<> ServerWindow::Client::recv(IOConsole& serverConsole, const Device& device, unsigned int size) {
+    auto stream = socket->recvStream(size);
 
-    auto recvResult = co_await socket->recv(size);
+    // Errors are returned instead of thrown since clients that disconnect abruptly make them common
+    while (auto result = co_await stream.next()) {
+        if (!*result) {
+            serverConsole.errorHandler(result->error());
+            co_return;
+        }
 
-    if (recvResult.closed) {
-        serverConsole.addInfo(std::format("{} closed connection.", formatDevice(device)));
-        console.addInfo("Client closed connection.");
-        socket->close();
-        connected = selected = false;
-    } else {
-        serverConsole.addText(recvResult.data, "", colors[colorIndex], true, formatDevice(device));
-        console.addText(recvResult.data);
+        auto& recvResult = **result;
+        if (recvResult.closed) {
+            serverConsole.addInfo(std::format("{} closed connection.", formatDevice(device)));
+            console.addInfo("Client closed connection.");
+            socket->close();
+            connected = selected = false;
+            co_return;
+        }
+
+        std::uint64_t timestamp = recvResult.timestamp;
+        serverConsole.addText(recvResult.data, "", colors[colorIndex], true, formatDevice(device), timestamp);
+        console.addText(recvResult.data, "", {}, true, "", timestamp);
     }
-    pendingRecv = false;
-} catch (const System::SystemError& error) {
-    serverConsole.errorHandler(error);
 }
 
-ServerWindow::ServerWindow(std::string_view title, const Device& serverInfo) :
-    Window(title), socket(makeServerSocket(serverInfo.type)), isDgram(serverInfo.type == ConnectionType::UDP) {
+ServerWindow::ServerWindow(std::string_view title, const Device& serverInfo, const SocketOptions& options) :
+    Window(title), socket(makeServerSocket(serverInfo.type)), isDgram(serverInfo.type == ConnectionType::UDP),
+    canSendFiles(isStreamType(serverInfo.type)) {
+    socket->setOptions(options);
     startServer(serverInfo);
     clientsWindowTitle = std::format("Clients: {}", getTitle());
 
@@ -101,7 +116,10 @@ void ServerWindow::startServer(const Device& serverInfo) try {
 
     // Format title and status messages
     std::string newTitle;
-    if (ip == IPType::None) {
+    if (serverInfo.type == ConnectionType::UnixStream || serverInfo.type == ConnectionType::UnixSeqPacket) {
+        newTitle = std::format("{} Server - {}##{}", type, serverInfo.address, serverInfo.address);
+        console.addInfo(std::format("Server is active on {}.", serverInfo.address));
+    } else if (ip == IPType::None) {
         newTitle = std::format("{} Server - port {}##{}", type, port, serverInfo.address);
         console.addInfo(std::format("Server is active on port {}.", port));
     } else {
@@ -116,25 +134,63 @@ void ServerWindow::startServer(const Device& serverInfo) try {
     setTitle(std::format("Invalid Server##{}", ImGui::GetTime()));
 }
 
+Task<> ServerWindow::broadcast(std::string data) {
+    std::vector<Task<>> sends;
+    for (const auto& [key, client] : clients) {
+        if (client.selected) {
+            if (isDgram) sends.push_back(socket->sendTo(key, data));
+            else if (client.connected) sends.push_back(client.socket->send(data));
+        }
+    }
+
+    try {
+        co_await Async::whenAll(std::move(sends));
+    } catch (const Async::TaskErrors& errors) {
+        for (const auto& error : errors.getErrors()) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const System::SystemError& e) {
+                console.errorHandler(e);
+            } catch (const std::exception& e) {
+                console.addError(e.what());
+            }
+        }
+    }
+}
+
 Task<> ServerWindow::accept() try {
     if (!socket->isValid() || pendingIO) co_return;
     pendingIO = true;
 
     auto [device, clientSocket] = co_await socket->accept();
 
-    std::string message = device.name.empty()
-        ? std::format("Accepted connection from {} on port {}.", device.address, device.port)
-        : std::format("Accepted connection from {} ({}) on port {}.", device.name, device.address, device.port);
+    // Unix socket clients have no port
+    bool isUnix = device.type == ConnectionType::UnixStream || device.type == ConnectionType::UnixSeqPacket;
+
+    std::string message;
+    if (isUnix)
+        message = std::format("Accepted connection from {}.", device.address);
+    else if (device.name.empty())
+        message = std::format("Accepted connection from {} on port {}.", device.address, device.port);
+    else
+        message = std::format("Accepted connection from {} ({}) on port {}.", device.name, device.address, device.port);
 
     console.addInfo(message);
 
     auto [it, didEmplace] = clients.try_emplace(device, std::move(clientSocket), colorIndex);
+    auto& client = it->second;
     if (didEmplace) {
         nextColor();
     } else {
-        it->second.socket = std::move(clientSocket);
-        it->second.connected = it->second.selected = true;
+        // Stop receiving from the previous connection before its socket is replaced
+        client.recvCancel.cancel();
+        client.recvCancel = {};
+        client.socket = std::move(clientSocket);
+        client.connected = client.selected = true;
     }
+
+    // Each client is read from by one coroutine for the lifetime of its connection
+    spawn(withCancellation(client.recvCancel.getToken(), client.recv(console, it->first, console.getRecvSize())));
     pendingIO = false;
 } catch (const System::SystemError& error) {
     console.errorHandler(error);
@@ -144,13 +200,13 @@ Task<> ServerWindow::recvDgram() try {
     if (!socket->isValid() || pendingIO) co_return;
     pendingIO = true;
 
-    auto [device, data] = co_await socket->recvFrom(console.getRecvSize());
+    auto [device, data, timestamp] = co_await socket->recvFrom(console.getRecvSize());
 
     auto [it, didEmplace] = clients.try_emplace(device, nullptr, colorIndex);
     if (didEmplace) nextColor(); // Advance colors if there is data received from a new client
 
-    console.addText(data, "", colors[it->second.colorIndex], true, formatDevice(device));
-    it->second.console.addText(data);
+    console.addText(data, "", colors[it->second.colorIndex], true, formatDevice(device), timestamp);
+    it->second.console.addText(data, "", {}, true, "", timestamp);
     pendingIO = false;
 } catch (const System::SystemError& error) {
     console.errorHandler(error);
@@ -201,8 +257,7 @@ void ServerWindow::onBeforeUpdate() {
     if (isDgram) {
         recvDgram();
     } else {
-        accept();
-        for (auto& client : clients) client.second.recv(console, client.first, console.getRecvSize());
+        spawn(accept());
     }
 
     // Draw opened client windows
@@ -219,13 +274,18 @@ void ServerWindow::onBeforeUpdate() {
 }
 
 void ServerWindow::onUpdate() {
+    // Send a file to all selected clients
+    if (canSendFiles && fileSender.update()) {
+        std::vector<std::weak_ptr<const Socket>> targets;
+        for (const auto& [key, client] : clients)
+            if (client.selected && client.connected) targets.push_back(client.socket);
+
+        spawn(fileSender.send(std::move(targets), console));
+    }
+
     // Send data to all clients
     if (auto s = console.updateWithTextbox()) {
-        for (const auto& [key, client] : clients) {
-            if (client.selected) {
-                if (isDgram) socket->sendTo(key, *s);
-                else if (client.connected) client.socket->send(*s);
-            }
-        }
+        console.addSent(*s);
+        spawn(broadcast(*s));
     }
 }
@@ -4,35 +4,41 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "console.hpp"
+#include "filesender.hpp"
 #include "ioconsole.hpp"
 #include "window.hpp"
 #include "net/device.hpp"
 #include "sockets/delegates/delegates.hpp"
 #include "sockets/socket.hpp"
+#include "utils/cancellation.hpp"
 #include "utils/task.hpp"
 
 // Handles a server socket in a GUI window.
 class ServerWindow : public Window {
     // Connection-oriented client.
     struct Client {
-        SocketPtr socket;
+        std::shared_ptr<Socket> socket; // Shared with file sends, which hold it while a chunk is sent
         Console console;
         int colorIndex;
         bool selected = true;
         bool opened = false;
         bool remove = false;
-        bool pendingRecv = false;
         bool connected = true;
+        CancelSource recvCancel; // Stops receiving so the client's reader does not resume after it is removed
 
         Client(SocketPtr&& socket, int colorIndex) : socket(std::move(socket)), colorIndex(colorIndex) {}
 
         ~Client() {
+            recvCancel.cancel();
             if (socket) socket->cancelIO();
         }
 
+        // Receives from the client until its connection ends.
         Task<> recv(IOConsole& serverConsole, const Device& device, unsigned int size);
     };
 
@@ -46,15 +52,20 @@ class ServerWindow : public Window {
     SocketPtr socket;
     std::map<Device, Client, CompDevices> clients;
     bool isDgram;
+    bool canSendFiles; // If clients are streams that files can be sent through
 
     bool pendingIO = false;
     int colorIndex = 0;
 
     IOConsole console;
+    FileSender fileSender;
     std::string clientsWindowTitle;
 
     void startServer(const Device& serverInfo);
 
+    // Sends data to the selected clients at once, reporting errors after all sends end.
+    Task<> broadcast(std::string data);
+
     // Accepts connection-oriented clients.
     Task<> accept();
 
@@ -72,7 +83,7 @@ class ServerWindow : public Window {
     void onUpdate() override;
 
 public:
-    explicit ServerWindow(std::string_view title, const Device& serverInfo);
+    ServerWindow(std::string_view title, const Device& serverInfo, const SocketOptions& options);
 
     ~ServerWindow() override;
 };
@@ -7,6 +7,7 @@
 #include <imgui.h>
 
 #include "gui/imguiext.hpp"
+#include "os/async.hpp"
 
 void drawAboutWindow(bool& open) {
     if (!open) return;
@@ -32,6 +33,38 @@ void drawAboutWindow(bool& open) {
     ImGui::SeparatorText("System");
     ImGui::Text("Built for: %s, %s", Config::plat, Config::arch);
 
+    ImGui::SeparatorText("Event Loop");
+    ImGui::Text("Backend: %s", Async::getBackendName(Async::getBackend()));
+
+    auto capabilities = Async::getCapabilities();
+    if (capabilities.empty()) ImGui::TextDisabled("No optional features on this platform");
+    else if (ImGui::BeginTable("capabilities", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Feature");
+        ImGui::TableSetupColumn("Supported");
+        ImGui::TableSetupColumn("Used");
+        ImGui::TableHeadersRow();
+
+        for (const auto& [name, supported, used] : capabilities) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", supported ? "Yes" : "No");
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", used ? "Yes" : "No");
+        }
+
+        ImGui::EndTable();
+    }
+
+    if (Async::getBackend() == Async::Backend::IOUring) {
+        auto stats = Async::getRingStats();
+        ImGui::Text("Queue entries: %u submission, %u completion", stats.sqEntries, stats.cqEntries);
+        ImGui::Text("Completion queue overflows: %llu (%llu completions dropped, %llu resizes)",
+            static_cast<unsigned long long>(stats.overflows), static_cast<unsigned long long>(stats.dropped),
+            static_cast<unsigned long long>(stats.resizes));
+    }
+
     if (copy) {
         ImGui::LogFinish();
         copy = false;
@@ -0,0 +1,59 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "newcapture.hpp"
+
+#include <format>
+#include <string>
+
+#include <imgui.h>
+
+#include "imguiext.hpp"
+#include "notifications.hpp"
+#include "components/capturewindow.hpp"
+#include "components/windowlist.hpp"
+#include "net/capture.hpp"
+#include "net/enums.hpp"
+
+void drawCaptureTab([[maybe_unused]] WindowList& connections) {
+#if OS_LINUX
+    if (!ImGui::BeginTabItem("Capture")) return;
+    ImGui::BeginChild("Output");
+
+    using enum ConnectionType;
+    static CaptureFilter filter;
+
+    using namespace ImGuiExt::Literals;
+
+    ImGui::TextWrapped("Captures the packets of a connection in both directions. Leave a field empty (or a port as "
+                       "0) to match any value. Requires CAP_NET_RAW.");
+
+    ImGui::SetNextItemWidth(15_fh);
+    ImGuiExt::inputText("Remote address", filter.remoteAddress);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(7_fh);
+    ImGuiExt::inputScalar("Remote port", filter.remotePort, 1, 10);
+
+    ImGui::SetNextItemWidth(15_fh);
+    ImGuiExt::inputText("Local address", filter.localAddress);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(7_fh);
+    ImGuiExt::inputScalar("Local port", filter.localPort, 1, 10);
+
+    ImGuiExt::radioButton("TCP", filter.type, TCP);
+    ImGuiExt::radioButton("UDP", filter.type, UDP);
+
+    ImGui::Spacing();
+    if (ImGui::Button("Start Capture")) {
+        auto title = std::format("{} Capture - {}|{} and {}|{}", getConnectionTypeName(filter.type),
+            filter.remoteAddress.empty() ? "*" : filter.remoteAddress, filter.remotePort,
+            filter.localAddress.empty() ? "*" : filter.localAddress, filter.localPort);
+
+        bool isNew = connections.add<CaptureWindow>(title, filter);
+        if (!isNew) ImGuiExt::addNotification("This capture is already open.", NotificationType::Warning);
+    }
+
+    ImGui::EndChild();
+    ImGui::EndTabItem();
+#endif
+}
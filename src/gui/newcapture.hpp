@@ -0,0 +1,9 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "components/windowlist.hpp"
+
+// Renders the tab in the "New Connection" window for capturing the packets of a connection (Linux only).
+void drawCaptureTab(WindowList& connections);
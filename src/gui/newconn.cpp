@@ -8,24 +8,29 @@
 #include <string_view>
 
 #include "imguiext.hpp"
+#include "newcapture.hpp"
 #include "newconnbt.hpp"
 #include "newconnip.hpp"
+#include "newconnunix.hpp"
 #include "notifications.hpp"
 #include "components/connwindow.hpp"
 #include "net/device.hpp"
 #include "net/enums.hpp"
+#include "sockets/delegates/delegates.hpp"
 #include "utils/strings.hpp"
 
 // Formats a Device instance into a string for use in a ConnWindow title.
 std::string formatDevice(bool useTLS, const Device& device, std::string_view extraInfo) {
     // Type of the connection
     bool isIP = device.type == ConnectionType::TCP || device.type == ConnectionType::UDP;
+    bool isUnix = device.type == ConnectionType::UnixStream || device.type == ConnectionType::UnixSeqPacket;
     const char* typeName = getConnectionTypeName(device.type);
     auto typeString = useTLS ? std::format("{}+TLS", typeName) : std::string{ typeName };
 
     // Bluetooth-based connections are described using the device's name (e.g. "MyESP32"),
-    // IP-based connections use the device's IP address (e.g. 192.168.0.178).
-    std::string deviceString = isIP ? device.address : device.name;
+    // IP-based connections use the device's IP address (e.g. 192.168.0.178), and Unix socket connections use the
+    // socket path.
+    std::string deviceString = isIP || isUnix ? device.address : device.name;
 
     // Newlines may be present in a Bluetooth device name, and if they get into a window's title, anything after the
     // first one will get cut off (the title bar can only hold one line). Replace them with left/down arrow icons
@@ -35,17 +40,23 @@ std::string formatDevice(bool useTLS, const Device& device, std::string_view ext
     // Format the values into a string as the title
     // The address is always part of the id hash.
     // The port is not visible for a Bluetooth connection, instead, it is part of the id hash.
-    std::string title = isIP
-        ? std::format("{} Connection - {} port {}##{}", typeString, deviceString, device.port, device.address)
-        : std::format("{} Connection - {}##{} port {}", typeString, deviceString, device.address, device.port);
+    // Unix socket connections have no port.
+    std::string title;
+    if (isIP)
+        title = std::format("{} Connection - {} port {}##{}", typeString, deviceString, device.port, device.address);
+    else if (isUnix)
+        title = std::format("{} Connection - {}##{}", typeString, deviceString, device.address);
+    else
+        title = std::format("{} Connection - {}##{} port {}", typeString, deviceString, device.address, device.port);
 
     // If there's extra info, it is formatted before the window title.
     // If it were to be put after the title, it would be part of the invisible id hash (after the "##").
     return extraInfo.empty() ? title : std::format("({}) {}", extraInfo, title);
 }
 
-void addConnWindow(WindowList& list, bool useTLS, const Device& device, std::string_view extraInfo) {
-    bool isNew = list.add<ConnWindow>(formatDevice(useTLS, device, extraInfo), useTLS, device, extraInfo);
+void addConnWindow(WindowList& list, bool useTLS, const Device& device, std::string_view extraInfo,
+    const SocketOptions& options) {
+    bool isNew = list.add<ConnWindow>(formatDevice(useTLS, device, extraInfo), useTLS, device, extraInfo, options);
 
     // If the connection exists, show a message
     if (!isNew) ImGuiExt::addNotification("This connection is already open.", NotificationType::Warning);
@@ -60,6 +71,8 @@ void drawNewConnectionWindow(bool& open, WindowList& connections, WindowList& sd
     if (ImGui::Begin("New Connection", &open) && ImGui::BeginTabBar("ConnectionTypes")) {
         drawIPConnectionTab(connections);
         drawBTConnectionTab(connections, sdpWindows);
+        if constexpr (!OS_WINDOWS) drawUnixConnectionTab(connections);
+        if constexpr (OS_LINUX) drawCaptureTab(connections);
         ImGui::EndTabBar();
     }
     ImGui::End();
@@ -7,9 +7,11 @@
 
 #include "components/windowlist.hpp"
 #include "net/device.hpp"
+#include "sockets/delegates/delegates.hpp"
 
 // Adds a ConnWindow to a window list and handles errors during socket creation.
-void addConnWindow(WindowList& list, bool useTLS, const Device& device, std::string_view extraInfo);
+void addConnWindow(WindowList& list, bool useTLS, const Device& device, std::string_view extraInfo,
+    const SocketOptions& options = {});
 
 // Draws the new connection window.
 void drawNewConnectionWindow(bool& open, WindowList& connections, WindowList& sdpWindows);
@@ -7,6 +7,7 @@
 #include <format>
 #include <functional>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -18,7 +19,9 @@
 #include "net/btutils.hpp"
 #include "net/device.hpp"
 #include "os/error.hpp"
+#include "os/offload.hpp"
 #include "utils/overload.hpp"
+#include "utils/task.hpp"
 
 void sortTable(std::vector<Device>& devices) {
     // A sort is only needed for 2 or more entries
@@ -80,21 +83,38 @@ const Device* drawPairedDevices(std::vector<Device>& devices, bool needsSort) {
     return ret;
 }
 
+// List of paired devices, or the error that occurred while getting them.
+using PairedDevices = std::variant<std::monostate, std::vector<Device>, System::SystemError>;
+
+// Gets the paired devices without blocking the GUI, since the OS can take a while to respond.
+Task<> getPairedDevices(PairedDevices& pairedDevices, bool& pending, bool& refreshed) {
+    try {
+        auto devices = co_await Async::offload(BTUtils::getPaired);
+        pairedDevices = std::move(devices);
+        refreshed = true;
+    } catch (const System::SystemError& error) {
+        pairedDevices = error;
+    }
+    pending = false;
+}
+
 void drawBTConnectionTab(WindowList& connections, WindowList& sdpWindows) {
     if (!ImGui::BeginTabItem("Bluetooth")) return;
 
-    static std::variant<std::monostate, std::vector<Device>, System::SystemError> pairedDevices;
-    bool needsSort = false;
+    static PairedDevices pairedDevices;
+    static bool pending = false;
+    static bool refreshed = false;
+
+    // A new list is sorted when it is first drawn
+    bool needsSort = std::exchange(refreshed, false);
 
     // Get paired devices if the button is clicked or if the variant currently holds nothing
-    if (ImGui::Button("Refresh List") || pairedDevices.index() == 0) {
-        try {
-            pairedDevices = BTUtils::getPaired();
-            needsSort = true;
-        } catch (const System::SystemError& error) {
-            pairedDevices = error;
-        }
+    ImGui::BeginDisabled(pending);
+    if ((ImGui::Button("Refresh List") || pairedDevices.index() == 0) && !pending) {
+        pending = true;
+        spawn(getPairedDevices(pairedDevices, pending, refreshed));
     }
+    ImGui::EndDisabled();
 
     // Check paired devices list
     Overload visitor{
@@ -8,8 +8,11 @@
 
 #include "imguiext.hpp"
 #include "newconn.hpp"
+#include "socketoptions.hpp"
+#include "app/settings.hpp"
 #include "components/windowlist.hpp"
 #include "net/enums.hpp"
+#include "sockets/delegates/delegates.hpp"
 
 // Gets the width of a rendered string added with the item inner spacing specified in the Dear ImGui style.
 float calcTextWidthWithSpacing(std::string_view text) {
@@ -26,6 +29,7 @@ void drawIPConnectionTab(WindowList& connections) {
     static std::uint16_t port = 0; // Server port
     static ConnectionType type = TCP; // Type of connection to create
     static bool useTLS = false; // If TLS is used for secure connections
+    static SocketOptions options = Settings::OS::socketOptions; // Options for the new socket
 
     // Widgets
     using namespace ImGuiExt::Literals;
@@ -60,7 +64,7 @@ void drawIPConnectionTab(WindowList& connections) {
     ImGui::Spacing();
     ImGui::BeginDisabled(addr.empty());
 
-    if (ImGui::Button("Connect")) addConnWindow(connections, useTLS, { type, "", addr, port }, "");
+    if (ImGui::Button("Connect")) addConnWindow(connections, useTLS, { type, "", addr, port }, "", options);
 
     ImGui::EndDisabled();
 
@@ -70,6 +74,8 @@ void drawIPConnectionTab(WindowList& connections) {
         ImGui::Checkbox("Use TLS", &useTLS);
     }
 
+    drawSocketOptionsOverride(options, type == TCP, false);
+
     ImGui::EndChild();
     ImGui::EndTabItem();
 }
@@ -0,0 +1,43 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "newconnunix.hpp"
+
+#include <string>
+
+#include <imgui.h>
+
+#include "imguiext.hpp"
+#include "newconn.hpp"
+#include "components/windowlist.hpp"
+#include "net/enums.hpp"
+
+void drawUnixConnectionTab(WindowList& connections) {
+    if (!ImGui::BeginTabItem("Unix Socket")) return;
+    ImGui::BeginChild("Output");
+
+    using enum ConnectionType;
+
+    static std::string path; // Socket path
+    static ConnectionType type = UnixStream; // Type of connection to create
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize("Path").x
+                            - ImGui::GetStyle().ItemInnerSpacing.x);
+    ImGuiExt::inputText("Path", path);
+    if constexpr (OS_LINUX) ImGuiExt::helpMarker("Start the path with @ to use a name in the abstract namespace.");
+
+    // Connection type selection
+    ImGuiExt::radioButton("Stream", type, UnixStream);
+    if constexpr (OS_LINUX) ImGuiExt::radioButton("Sequenced packet", type, UnixSeqPacket);
+
+    // Connect button
+    ImGui::Spacing();
+    ImGui::BeginDisabled(path.empty());
+
+    if (ImGui::Button("Connect")) addConnWindow(connections, false, { type, "", path, 0 }, "");
+
+    ImGui::EndDisabled();
+
+    ImGui::EndChild();
+    ImGui::EndTabItem();
+}
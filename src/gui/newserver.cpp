@@ -6,16 +6,20 @@
 #include <imgui.h>
 
 #include "imguiext.hpp"
+#include "socketoptions.hpp"
+#include "app/settings.hpp"
+#include "components/relaywindow.hpp"
 #include "components/serverwindow.hpp"
 #include "net/device.hpp"
 #include "net/enums.hpp"
+#include "sockets/delegates/delegates.hpp"
 
 void drawNewServerWindow(WindowList& servers, bool& open) {
     if (!open) return;
 
     using namespace ImGuiExt::Literals;
 
-    ImGui::SetNextWindowSize(35_fh * 13_fh, ImGuiCond_Appearing);
+    ImGui::SetNextWindowSize(35_fh * 15_fh, ImGuiCond_Appearing);
     if (!ImGui::Begin("New Server", &open)) {
         ImGui::End();
         return;
@@ -23,6 +27,9 @@ void drawNewServerWindow(WindowList& servers, bool& open) {
 
     using enum ConnectionType;
     static Device serverInfo{ TCP, "", "", 0 };
+    static SocketOptions options = Settings::OS::socketOptions;
+    static bool useRelay = false;
+    static Device relayTarget{ TCP, "", "", 0 };
 
     if (serverInfo.type == TCP || serverInfo.type == UDP) {
         ImGui::SetNextItemWidth(15_fh);
@@ -37,16 +44,48 @@ void drawNewServerWindow(WindowList& servers, bool& open) {
         ImGui::SameLine();
     }
 
-    ImGui::SetNextItemWidth(7_fh);
-    ImGuiExt::inputScalar("Port", serverInfo.port, 1, 10);
+    // Unix sockets are bound to a path instead of a port
+    if (serverInfo.type == UnixStream || serverInfo.type == UnixSeqPacket) {
+        ImGui::SetNextItemWidth(25_fh);
+        ImGuiExt::inputText("Path", serverInfo.address);
+        if constexpr (OS_LINUX) ImGuiExt::helpMarker("Start the path with @ to use a name in the abstract namespace.");
+    } else {
+        ImGui::SetNextItemWidth(7_fh);
+        ImGuiExt::inputScalar("Port", serverInfo.port, 1, 10);
+    }
 
     ImGuiExt::radioButton("TCP", serverInfo.type, TCP);
     ImGuiExt::radioButton("UDP", serverInfo.type, UDP);
     ImGuiExt::radioButton("RFCOMM", serverInfo.type, RFCOMM);
     if constexpr (!OS_WINDOWS) ImGuiExt::radioButton("L2CAP", serverInfo.type, L2CAP);
+    if constexpr (!OS_WINDOWS) ImGuiExt::radioButton("Unix stream", serverInfo.type, UnixStream);
+    if constexpr (OS_LINUX) ImGuiExt::radioButton("Unix sequenced packet", serverInfo.type, UnixSeqPacket);
+
+    // Socket options are only supported on Internet Protocol servers
+    if (serverInfo.type == TCP || serverInfo.type == UDP)
+        drawSocketOptionsOverride(options, serverInfo.type == TCP, true);
+
+    // TCP servers can forward their clients to another host
+    bool canRelay = serverInfo.type == TCP;
+    if (canRelay) {
+        ImGui::Checkbox("Relay to", &useRelay);
+        ImGuiExt::helpMarker("Forward each client to a target host instead of displaying its data.");
+
+        ImGui::BeginDisabled(!useRelay);
+        ImGui::SetNextItemWidth(15_fh);
+        ImGuiExt::inputText("Target address", relayTarget.address);
+
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(7_fh);
+        ImGuiExt::inputScalar("Target port", relayTarget.port, 1, 10);
+        ImGui::EndDisabled();
+    }
 
     // Cannot check the result of add since server titles are generated dynamically.
-    if (ImGui::Button("Create Server")) servers.add<ServerWindow>("", serverInfo);
+    if (ImGui::Button("Create Server")) {
+        if (canRelay && useRelay) servers.add<RelayWindow>("", serverInfo, relayTarget, options);
+        else servers.add<ServerWindow>("", serverInfo, options);
+    }
 
     ImGui::End();
 }
@@ -0,0 +1,71 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "socketoptions.hpp"
+
+#include <imgui.h>
+
+#include "imguiext.hpp"
+#include "app/settings.hpp"
+#include "sockets/delegates/delegates.hpp"
+
+void drawSocketOptions(SocketOptions& options, bool isTCP, bool showClient, bool showServer) {
+    using namespace ImGuiExt::Literals;
+
+    ImGui::PushID("socketOptions");
+
+    if (isTCP) {
+        ImGui::Checkbox("TCP_NODELAY", &options.noDelay);
+        ImGuiExt::helpMarker("Disable Nagle's algorithm so small writes are sent immediately.");
+
+        if constexpr (OS_LINUX) {
+            ImGui::Checkbox("TCP_QUICKACK", &options.quickAck);
+            ImGuiExt::helpMarker("Acknowledge received data immediately instead of delaying ACKs.");
+        }
+
+        // Client-side Fast Open is Linux-only
+        if (showServer || (showClient && OS_LINUX)) {
+            ImGui::Checkbox("TCP Fast Open", &options.fastOpen);
+            ImGuiExt::helpMarker("Send data with the connection handshake. Both sides must support Fast Open, on "
+                                 "Linux it must be enabled with the net.ipv4.tcp_fastopen sysctl.");
+        }
+
+        if (showServer && OS_LINUX) {
+            ImGui::Checkbox("Defer accept", &options.deferAccept);
+            ImGuiExt::helpMarker("Only accept clients once they have sent data.");
+        }
+    }
+
+    ImGui::SetNextItemWidth(8_fh);
+    ImGuiExt::inputScalar("Receive buffer size (bytes)", options.recvBufSize);
+
+    ImGui::SetNextItemWidth(8_fh);
+    ImGuiExt::inputScalar("Send buffer size (bytes)", options.sendBufSize);
+    ImGuiExt::helpMarker("0 to use the system default.");
+
+    if constexpr (OS_LINUX) {
+        ImGui::SetNextItemWidth(8_fh);
+        ImGuiExt::inputScalar("Busy poll (microseconds)", options.busyPoll);
+        ImGuiExt::helpMarker("Poll the device for received data instead of waiting for interrupts. 0 to disable. "
+                             "Values above the net.core.busy_read sysctl need the CAP_NET_ADMIN capability.");
+
+        ImGui::SetNextItemWidth(8_fh);
+        ImGuiExt::inputScalar("Max pacing rate (bytes/s)", options.maxPacingRate);
+        ImGuiExt::helpMarker("0 for unlimited.");
+
+        ImGui::Checkbox("Kernel timestamps", &options.timestamps);
+        ImGuiExt::helpMarker("Show the times that the kernel received and transmitted data, instead of the times they "
+                             "were shown in the output.");
+    }
+
+    ImGui::PopID();
+}
+
+void drawSocketOptionsOverride(SocketOptions& options, bool isTCP, bool isServer) {
+    if (!ImGui::TreeNode("Socket options")) return;
+
+    if (ImGui::Button("Reset to defaults")) options = Settings::OS::socketOptions;
+    drawSocketOptions(options, isTCP, !isServer, isServer);
+
+    ImGui::TreePop();
+}
@@ -0,0 +1,13 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "sockets/delegates/delegates.hpp"
+
+// Draws widgets to edit socket options.
+// TCP-specific options are shown if isTCP is set, client and server options are shown with the respective flags.
+void drawSocketOptions(SocketOptions& options, bool isTCP, bool showClient, bool showServer);
+
+// Draws a collapsible section to override the default socket options for a new socket.
+void drawSocketOptionsOverride(SocketOptions& options, bool isTCP, bool isServer);
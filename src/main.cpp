@@ -1,7 +1,13 @@
 // Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
 #include <optional>
+#include <string_view>
 #include <system_error>
 
 #include "app/appcore.hpp"
@@ -14,6 +20,9 @@
 #include "gui/newserver.hpp"
 #include "gui/notifications.hpp"
 #include "net/btutils.hpp"
+#include "net/device.hpp"
+#include "net/enums.hpp"
+#include "net/relay.hpp"
 #include "os/async.hpp"
 #include "os/error.hpp"
 
@@ -46,12 +55,95 @@ void mainLoop() {
     }
 }
 
+// Parses a port number from a command line argument.
+std::optional<std::uint16_t> parsePort(std::string_view arg) {
+    std::uint16_t port = 0;
+    auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), port);
+    if (ec != std::errc{} || ptr != arg.data() + arg.size()) return std::nullopt;
+    return port;
+}
+
+// Runs a TCP relay without the GUI until the process is terminated.
+// Arguments: --relay <listen port> <target host> <target port>
+int runRelay(int argc, char** argv) {
+    auto port = argc == 5 ? parsePort(argv[2]) : std::nullopt;
+    auto targetPort = argc == 5 ? parsePort(argv[4]) : std::nullopt;
+    if (!port || !targetPort) {
+        std::cerr << "Usage: " << argv[0] << " --relay <listen port> <target host> <target port>\n";
+        return 1;
+    }
+
+    try {
+        // The relay runs on the main thread, but uses the event loop and socket settings of the application
+        Settings::load();
+        Async::init(1, Settings::OS::queueEntries,
+            Settings::OS::forceEpoll ? Async::Backend::Epoll : Async::Backend::Auto, Settings::OS::eventLoopBusyPoll);
+
+        using enum ConnectionType;
+        Relay relay{ { TCP, "", "0.0.0.0", *port }, { TCP, "", argv[3], *targetPort }, Settings::OS::socketOptions,
+            [](std::string_view message, bool isError) {
+                (isError ? std::cerr : std::cout) << message << "\n";
+            } };
+
+        std::cout << "Relaying port " << relay.getAddress().port << " to " << argv[3] << " port " << *targetPort
+                  << ".\n";
+
+        // Report the counters periodically while they change
+        using namespace std::literals;
+        auto lastReport = std::chrono::steady_clock::now();
+        RelayStats lastStats;
+        bool modeReported = false;
+        while (true) {
+            relay.update();
+            Async::handleEvents();
+
+            const RelayStats& stats = relay.getStats();
+
+            // Splicing support is only known once the first connection has forwarded data
+            if (!modeReported && stats.toTarget + stats.toClients > 0) {
+                std::cout << "Forwarding data in " << (relay.usesSplice() ? "splice" : "copy") << " mode.\n";
+                modeReported = true;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport < 5s || stats.toTarget + stats.toClients == lastStats.toTarget + lastStats.toClients)
+                continue;
+
+            std::cout << stats.active << " active, " << stats.accepted << " accepted, " << stats.toTarget
+                      << " bytes to target, " << stats.toClients << " bytes to clients\n";
+            lastReport = now;
+            lastStats = stats;
+        }
+    } catch (const System::SystemError& error) {
+        std::cerr << "Relay error: " << error.what() << "\n";
+        Async::cleanup();
+        return 1;
+    }
+}
+
 #if OS_WINDOWS
 int WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 #else
-int main(int, char**)
+int main(int argc, char** argv)
 #endif
 {
+#if OS_WINDOWS
+    int argc = __argc;
+    char** argv = __argv;
+#endif
+
+    // Run without the GUI if a relay is requested
+    if (argc > 1 && std::string_view{ argv[1] } == "--relay") {
+#if OS_WINDOWS
+        // GUI applications do not have a console, so output goes to the one that started the process
+        if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+            std::freopen("CONOUT$", "w", stdout);
+            std::freopen("CONOUT$", "w", stderr);
+        }
+#endif
+        return runRelay(argc, argv);
+    }
+
     // Create a main application window
     if (!AppCore::init()) return 1;
     if (Settings::GUI::systemMenu) Menu::setupMenuBar();
@@ -63,7 +155,8 @@ int main(int, char**)
 
     // Initialize APIs for sockets and Bluetooth
     try {
-        Async::init(Settings::OS::numThreads, Settings::OS::queueEntries);
+        Async::init(Settings::OS::numThreads, Settings::OS::queueEntries,
+            Settings::OS::forceEpoll ? Async::Backend::Epoll : Async::Backend::Auto, Settings::OS::eventLoopBusyPoll);
         btutilsInstance.emplace();
     } catch (const System::SystemError& error) {
         ImGuiExt::addNotification("Initialization error "s + error.what(), NotificationType::Error, 0);
@@ -0,0 +1,107 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <linux/filter.h>
+
+#include "enums.hpp"
+#include "utils/task.hpp"
+
+// Connection that packets are captured for. Packets going in either direction are captured.
+// Empty addresses and zero ports match any value.
+struct CaptureFilter {
+    ConnectionType type = ConnectionType::TCP; // Transport protocol (TCP or UDP)
+    std::string remoteAddress; // Address of the remote host (name or IP address)
+    std::uint16_t remotePort = 0;
+    std::string localAddress; // Address of this host, must be the same IP version as the remote address
+    std::uint16_t localPort = 0;
+};
+
+// Packet read from the capture ring.
+struct CapturedPacket {
+    std::span<const std::uint8_t> data; // Network layer packet, truncated to the capture length
+    std::uint32_t length; // Length of the packet before truncation
+    std::uint64_t timestamp; // Time of capture in nanoseconds since the Unix epoch
+    bool outgoing; // If the packet was sent by this host
+};
+
+// Counters of a capture.
+struct CaptureStats {
+    std::uint64_t packets = 0; // Packets passed to the ring
+    std::uint64_t drops = 0; // Packets dropped because the ring was full
+};
+
+// Creates a BPF program that accepts the packets of a connection, for the network layer packets seen by a capture.
+// Names in the filter are resolved on an offload thread. Throws if they cannot be resolved, or if the addresses use
+// different IP versions.
+Task<std::vector<sock_filter>> makeFilter(CaptureFilter filter);
+
+// Captures packets with an AF_PACKET socket and a TPACKET_V3 ring mapped into memory (Linux only).
+//
+// The kernel fills blocks of the ring with packets and hands them over once they are full or a timeout passes, so
+// packets are read from the ring without copying them or making a system call for each one. A BPF program attached to
+// the socket drops packets that do not match the filter before they reach the ring.
+class PacketCapture {
+    // Socket and mapped ring, shared with pending reads so the ring stays mapped until they end.
+    struct Ring {
+        int fd = -1;
+        std::uint8_t* data = nullptr;
+        std::size_t blockSize = 0;
+        unsigned int numBlocks = 0;
+        unsigned int currentBlock = 0; // Next block to read
+        bool closed = false; // If the capture was destroyed, in which case reads that wake up are canceled
+
+        Ring() = default;
+
+        // Unmaps the ring and closes the socket.
+        ~Ring();
+
+        Ring(const Ring&) = delete;
+
+        Ring& operator=(const Ring&) = delete;
+
+        // Checks if the current block has been handed over by the kernel.
+        bool isBlockReady() const;
+    };
+
+    std::shared_ptr<Ring> ring = std::make_shared<Ring>();
+    CaptureStats stats;
+
+public:
+    // Opens the capture socket with a program from makeFilter(). Requires CAP_NET_RAW, throws if the socket cannot be
+    // opened.
+    explicit PacketCapture(std::span<const sock_filter> program);
+
+    // Cancels pending reads. The ring is unmapped and the socket is closed once they have ended.
+    ~PacketCapture();
+
+    PacketCapture(const PacketCapture&) = delete;
+
+    PacketCapture& operator=(const PacketCapture&) = delete;
+
+    // Waits for packets, then passes each packet in the blocks that are ready to a function.
+    // The packet data is in the ring and is only valid until the function returns. Returns the number of packets read.
+    // The function is passed by value so it stays valid while the read is suspended.
+    Task<std::size_t> read(std::function<void(const CapturedPacket&)> fn);
+
+    // Cancels a pending read.
+    void cancel();
+
+    // Gets the packet counters, adding the ones collected by the kernel since the last call.
+    const CaptureStats& getStats();
+};
+
+// Formats the addresses, ports, and protocol of a captured packet (e.g. "192.0.2.1:443 > 192.0.2.2:51000 TCP").
+std::string formatPacketHeaders(std::span<const std::uint8_t> data);
+
+// Gets the transport layer payload of a captured packet, or an empty span if it cannot be found.
+std::span<const std::uint8_t> getPacketPayload(std::span<const std::uint8_t> data);
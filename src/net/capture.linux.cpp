@@ -0,0 +1,350 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "capture.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include "device.hpp"
+#include "netutils.hpp"
+#include "os/async.hpp"
+#include "os/errcheck.hpp"
+#include "os/error.hpp"
+#include "os/offload.hpp"
+#include "utils/task.hpp"
+
+// Ring layout: blocks are handed to user space when they are full, or after the timeout (in milliseconds)
+constexpr std::size_t ringBlockSize = 1 << 20;
+constexpr unsigned int ringNumBlocks = 8;
+constexpr unsigned int ringFrameSize = 2048; // Only used by the kernel to validate the layout with TPACKET_V3
+constexpr unsigned int ringBlockTimeout = 100;
+
+// Offsets of fields in IP headers
+constexpr std::uint32_t ipv4Protocol = 9;
+constexpr std::uint32_t ipv4Fragment = 6;
+constexpr std::uint32_t ipv4Source = 12;
+constexpr std::uint32_t ipv4Dest = 16;
+constexpr std::uint32_t ipv6NextHeader = 6;
+constexpr std::uint32_t ipv6Source = 8;
+constexpr std::uint32_t ipv6Dest = 24;
+constexpr std::uint32_t ipv6HeaderSize = 40;
+
+// Address that a filter matches, as 32-bit words in host byte order.
+struct FilterAddress {
+    int family = AF_UNSPEC; // AF_UNSPEC to match any address
+    std::array<std::uint32_t, 4> words{};
+};
+
+// Resolves an address in a capture filter.
+Task<FilterAddress> resolveFilterAddress(ConnectionType type, const std::string& address) {
+    if (address.empty()) co_return {};
+
+    // The address is copied since the lookup keeps running if this coroutine is canceled and destroyed
+    auto resolve = [type, address] { return NetUtils::resolveAddr({ type, "", address, 0 }); };
+    auto resolved = co_await Async::offload(std::move(resolve));
+    FilterAddress ret{ resolved->ai_family };
+
+    if (resolved->ai_family == AF_INET) {
+        ret.words[0] = ntohl(reinterpret_cast<const sockaddr_in*>(resolved->ai_addr)->sin_addr.s_addr);
+    } else {
+        const auto& addr = reinterpret_cast<const sockaddr_in6*>(resolved->ai_addr)->sin6_addr;
+        std::memcpy(ret.words.data(), addr.s6_addr, sizeof(addr.s6_addr));
+        for (auto& i : ret.words) i = ntohl(i);
+    }
+
+    co_return ret;
+}
+
+// Builds a classic BPF program.
+// Jumps can only go forward, so their targets are labels that are placed after them.
+class FilterBuilder {
+    std::vector<sock_filter> code;
+    std::vector<std::size_t> labels; // Instruction index of each label
+    std::vector<std::tuple<std::size_t, int, int>> jumps; // Jump instruction index, and labels to jump to
+
+public:
+    // Label for the instruction after a jump.
+    static constexpr int next = -1;
+
+    int newLabel() {
+        labels.push_back(0);
+        return static_cast<int>(labels.size() - 1);
+    }
+
+    void place(int label) {
+        labels[label] = code.size();
+    }
+
+    void add(std::uint16_t op, std::uint32_t k) {
+        code.push_back(BPF_STMT(op, k));
+    }
+
+    // Adds a conditional jump to one label if the condition is true, or another if it is false.
+    void jump(std::uint16_t op, std::uint32_t k, int jt, int jf) {
+        jumps.emplace_back(code.size(), jt, jf);
+        code.push_back(BPF_JUMP(op, k, 0, 0));
+    }
+
+    // Resolves the jumps and returns the program.
+    std::vector<sock_filter> build() {
+        for (auto [i, jt, jf] : jumps) {
+            auto offset = [i](std::size_t target) { return static_cast<std::uint8_t>(target - i - 1); };
+            if (jt != next) code[i].jt = offset(labels[jt]);
+            if (jf != next) code[i].jf = offset(labels[jf]);
+        }
+
+        return code;
+    }
+};
+
+// Adds checks that a packet goes from one endpoint to another, jumping to a label if it does not.
+// On IPv4, the header length must be loaded into the X register first.
+void matchDirection(FilterBuilder& builder, bool isV4, const FilterAddress& srcAddr, std::uint16_t srcPort,
+    const FilterAddress& destAddr, std::uint16_t destPort, int mismatch) {
+    auto matchAddr = [&](const FilterAddress& addr, std::uint32_t offset) {
+        if (addr.family == AF_UNSPEC) return;
+
+        for (int i = 0; i < (isV4 ? 1 : 4); i++) {
+            builder.add(BPF_LD | BPF_W | BPF_ABS, offset + i * 4);
+            builder.jump(BPF_JMP | BPF_JEQ | BPF_K, addr.words[i], FilterBuilder::next, mismatch);
+        }
+    };
+
+    // Ports are at the start of the TCP and UDP headers
+    auto matchPort = [&](std::uint16_t port, std::uint32_t offset) {
+        if (port == 0) return;
+
+        if (isV4) builder.add(BPF_LD | BPF_H | BPF_IND, offset);
+        else builder.add(BPF_LD | BPF_H | BPF_ABS, ipv6HeaderSize + offset);
+        builder.jump(BPF_JMP | BPF_JEQ | BPF_K, port, FilterBuilder::next, mismatch);
+    };
+
+    matchAddr(srcAddr, isV4 ? ipv4Source : ipv6Source);
+    matchAddr(destAddr, isV4 ? ipv4Dest : ipv6Dest);
+    matchPort(srcPort, 0);
+    matchPort(destPort, 2);
+}
+
+// Packets start at the network layer header. IPv6 packets with extension headers are not matched.
+Task<std::vector<sock_filter>> makeFilter(CaptureFilter filter) {
+    FilterAddress remote = co_await resolveFilterAddress(filter.type, filter.remoteAddress);
+    FilterAddress local = co_await resolveFilterAddress(filter.type, filter.localAddress);
+
+    // Both addresses must use the same IP version
+    int family = remote.family == AF_UNSPEC ? local.family : remote.family;
+    if (local.family != AF_UNSPEC && local.family != family)
+        throw System::SystemError{ EAFNOSUPPORT, System::ErrorType::System };
+
+    std::uint32_t protocol = filter.type == ConnectionType::UDP ? IPPROTO_UDP : IPPROTO_TCP;
+    constexpr std::uint32_t acceptAll = 0xFFFFFFFF; // Return value to capture entire packets
+
+    FilterBuilder builder;
+    int reject = builder.newLabel();
+
+    for (bool isV4 : { true, false }) {
+        if (family != AF_UNSPEC && isV4 != (family == AF_INET)) continue;
+
+        int nextVersion = builder.newLabel();
+        int outgoing = builder.newLabel();
+
+        // IP version, in the upper 4 bits of the first byte
+        builder.add(BPF_LD | BPF_B | BPF_ABS, 0);
+        builder.add(BPF_ALU | BPF_AND | BPF_K, 0xF0);
+        builder.jump(BPF_JMP | BPF_JEQ | BPF_K, isV4 ? 0x40 : 0x60, FilterBuilder::next, nextVersion);
+
+        builder.add(BPF_LD | BPF_B | BPF_ABS, isV4 ? ipv4Protocol : ipv6NextHeader);
+        builder.jump(BPF_JMP | BPF_JEQ | BPF_K, protocol, FilterBuilder::next, reject);
+
+        if (isV4) {
+            // Only the first fragment has the ports
+            builder.add(BPF_LD | BPF_H | BPF_ABS, ipv4Fragment);
+            builder.jump(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, reject, FilterBuilder::next);
+            builder.add(BPF_LDX | BPF_B | BPF_MSH, 0);
+        }
+
+        // Received from the remote host, or sent to it
+        matchDirection(builder, isV4, remote, filter.remotePort, local, filter.localPort, outgoing);
+        builder.add(BPF_RET | BPF_K, acceptAll);
+
+        builder.place(outgoing);
+        matchDirection(builder, isV4, local, filter.localPort, remote, filter.remotePort, reject);
+        builder.add(BPF_RET | BPF_K, acceptAll);
+
+        builder.place(nextVersion);
+    }
+
+    builder.place(reject);
+    builder.add(BPF_RET | BPF_K, 0);
+    co_return builder.build();
+}
+
+PacketCapture::Ring::~Ring() {
+    if (data) munmap(data, blockSize * numBlocks);
+    if (fd != -1) Async::submit(Async::Close{ { fd, nullptr } });
+}
+
+bool PacketCapture::Ring::isBlockReady() const {
+    auto block = reinterpret_cast<tpacket_block_desc*>(data + currentBlock * blockSize);
+    std::atomic_ref status{ block->hdr.bh1.block_status };
+    return status.load(std::memory_order_acquire) & TP_STATUS_USER;
+}
+
+PacketCapture::PacketCapture(std::span<const sock_filter> program) {
+    // Datagram packet sockets remove link layer headers, so the filter sees the same layout on every interface.
+    // The socket receives nothing until it is bound, so no unfiltered packets are queued before the filter is attached.
+    // If anything fails, the ring unmaps and closes what was set up.
+    int fd = ring->fd = check(socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, 0));
+
+    // The kernel copies the program when it is attached
+    sock_fprog fprog{ static_cast<unsigned short>(program.size()), const_cast<sock_filter*>(program.data()) };
+    check(setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)));
+
+    int version = TPACKET_V3;
+    check(setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)));
+
+    tpacket_req3 req{
+        .tp_block_size = ringBlockSize,
+        .tp_block_nr = ringNumBlocks,
+        .tp_frame_size = ringFrameSize,
+        .tp_frame_nr = ringBlockSize / ringFrameSize * ringNumBlocks,
+        .tp_retire_blk_tov = ringBlockTimeout,
+    };
+    check(setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)));
+
+    void* mapped = mmap(nullptr, ringBlockSize * ringNumBlocks, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+        0);
+    ring->data = static_cast<std::uint8_t*>(check(mapped, [](void* p) { return p != MAP_FAILED; }));
+    ring->blockSize = ringBlockSize;
+    ring->numBlocks = ringNumBlocks;
+
+    // Capture on all interfaces
+    sockaddr_ll addr{ .sll_family = AF_PACKET, .sll_protocol = htons(ETH_P_ALL) };
+    check(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+}
+
+PacketCapture::~PacketCapture() {
+    // Pending reads keep the ring mapped until they end, and are canceled if they wake up after this
+    ring->closed = true;
+    cancel();
+}
+
+Task<std::size_t> PacketCapture::read(std::function<void(const CapturedPacket&)> fn) {
+    // Packets are read through this reference, so the ring is not unmapped while the read is suspended
+    auto state = ring;
+
+    while (!state->isBlockReady()) {
+        co_await Async::readable(state->fd);
+        if (state->closed) throw System::SystemError{ ECANCELED, System::ErrorType::System };
+    }
+
+    std::size_t count = 0;
+    while (state->isBlockReady()) {
+        auto block = reinterpret_cast<tpacket_block_desc*>(state->data + state->currentBlock * state->blockSize);
+        const auto& blockHeader = block->hdr.bh1;
+
+        auto packet = reinterpret_cast<const std::uint8_t*>(block) + blockHeader.offset_to_first_pkt;
+        for (unsigned int i = 0; i < blockHeader.num_pkts; i++) {
+            auto header = reinterpret_cast<const tpacket3_hdr*>(packet);
+            auto addr = reinterpret_cast<const sockaddr_ll*>(packet + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+
+            fn({ { packet + header->tp_net, header->tp_snaplen }, header->tp_len,
+                header->tp_sec * 1'000'000'000ULL + header->tp_nsec, addr->sll_pkttype == PACKET_OUTGOING });
+            packet += header->tp_next_offset;
+        }
+
+        count += blockHeader.num_pkts;
+
+        // Give the block back to the kernel
+        std::atomic_ref status{ block->hdr.bh1.block_status };
+        status.store(TP_STATUS_KERNEL, std::memory_order_release);
+        state->currentBlock = (state->currentBlock + 1) % state->numBlocks;
+    }
+
+    co_return count;
+}
+
+void PacketCapture::cancel() {
+    Async::submit(Async::Cancel{ { ring->fd, nullptr } });
+}
+
+const CaptureStats& PacketCapture::getStats() {
+    // The kernel resets its counters every time they are read
+    tpacket_stats_v3 kernelStats{};
+    socklen_t len = sizeof(kernelStats);
+    if (getsockopt(ring->fd, SOL_PACKET, PACKET_STATISTICS, &kernelStats, &len) == 0) {
+        stats.packets += kernelStats.tp_packets;
+        stats.drops += kernelStats.tp_drops;
+    }
+
+    return stats;
+}
+
+// Location of the headers in a captured packet.
+struct PacketHeaders {
+    bool isV4;
+    std::uint8_t protocol;
+    std::size_t transportOffset; // Offset of the TCP or UDP header
+};
+
+std::optional<PacketHeaders> parseHeaders(std::span<const std::uint8_t> data) {
+    if (data.empty()) return std::nullopt;
+
+    bool isV4 = (data[0] >> 4) == 4;
+    if (isV4 && data.size() >= 20) return PacketHeaders{ true, data[ipv4Protocol], (data[0] & 0x0Fu) * 4u };
+    if (!isV4 && data.size() >= ipv6HeaderSize) return PacketHeaders{ false, data[ipv6NextHeader], ipv6HeaderSize };
+    return std::nullopt;
+}
+
+std::string formatPacketHeaders(std::span<const std::uint8_t> data) {
+    auto headers = parseHeaders(data);
+    if (!headers) return "Unknown packet";
+
+    int family = headers->isV4 ? AF_INET : AF_INET6;
+    char srcAddr[INET6_ADDRSTRLEN]{};
+    char destAddr[INET6_ADDRSTRLEN]{};
+    inet_ntop(family, data.data() + (headers->isV4 ? ipv4Source : ipv6Source), srcAddr, sizeof(srcAddr));
+    inet_ntop(family, data.data() + (headers->isV4 ? ipv4Dest : ipv6Dest), destAddr, sizeof(destAddr));
+
+    bool hasPorts = headers->protocol == IPPROTO_TCP || headers->protocol == IPPROTO_UDP;
+    const char* protocol = headers->protocol == IPPROTO_TCP ? "TCP" : headers->protocol == IPPROTO_UDP ? "UDP" : "IP";
+    std::size_t offset = headers->transportOffset;
+    if (!hasPorts || data.size() < offset + 4) return std::format("{} > {} {}", srcAddr, destAddr, protocol);
+
+    // IPv6 addresses are bracketed to separate them from the ports
+    auto port = [&](std::size_t i) { return (data[offset + i] << 8) | data[offset + i + 1]; };
+    if (headers->isV4) return std::format("{}:{} > {}:{} {}", srcAddr, port(0), destAddr, port(2), protocol);
+    return std::format("[{}]:{} > [{}]:{} {}", srcAddr, port(0), destAddr, port(2), protocol);
+}
+
+std::span<const std::uint8_t> getPacketPayload(std::span<const std::uint8_t> data) {
+    auto headers = parseHeaders(data);
+    if (!headers) return {};
+
+    std::size_t offset = headers->transportOffset;
+    if (headers->protocol == IPPROTO_TCP && data.size() >= offset + 20) offset += (data[offset + 12] >> 4) * 4;
+    else if (headers->protocol == IPPROTO_UDP && data.size() >= offset + 8) offset += 8;
+    else return {};
+
+    return offset <= data.size() ? data.subspan(offset) : std::span<const std::uint8_t>{};
+}
@@ -12,6 +12,6 @@
 struct Device {
     ConnectionType type = ConnectionType::None; // Connection protocol
     std::string name; // Device name for display
-    std::string address; // Address (IP address for TCP / UDP, MAC address for Bluetooth)
-    std::uint16_t port = 0; // Port (or PSM for L2CAP, channel for RFCOMM)
+    std::string address; // Address (IP address for TCP / UDP, MAC address for Bluetooth, path for Unix sockets)
+    std::uint16_t port = 0; // Port (or PSM for L2CAP, channel for RFCOMM, unused for Unix sockets)
 };
@@ -4,11 +4,12 @@
 #pragma once
 
 // Enumeration to determine socket types at compile time.
-enum class SocketTag { IP, BT };
+enum class SocketTag { IP, BT, Unix };
 
 // All possible connection types.
 // L2CAP connections are not supported on Windows because of limitations with the Microsoft Bluetooth stack.
-enum class ConnectionType { None, TCP, UDP, L2CAP, RFCOMM };
+// Unix domain sockets are not supported on Windows, and sequenced-packet Unix sockets are only supported on Linux.
+enum class ConnectionType { None, TCP, UDP, L2CAP, RFCOMM, UnixStream, UnixSeqPacket };
 
 // IP versions.
 enum class IPType { None, IPv4, IPv6 };
@@ -24,6 +25,10 @@ inline const char* getConnectionTypeName(ConnectionType type) {
             return "L2CAP";
         case RFCOMM:
             return "RFCOMM";
+        case UnixStream:
+            return "Unix Stream";
+        case UnixSeqPacket:
+            return "Unix SeqPacket";
         case None:
             return "None";
         default:
@@ -31,6 +36,12 @@ inline const char* getConnectionTypeName(ConnectionType type) {
     }
 }
 
+// Checks if a connection type transfers a stream of bytes instead of separate messages.
+inline bool isStreamType(ConnectionType type) {
+    using enum ConnectionType;
+    return type == TCP || type == RFCOMM || type == UnixStream;
+}
+
 inline const char* getIPTypeName(IPType type) {
     using enum IPType;
     switch (type) {
@@ -5,6 +5,18 @@
 
 #include <ztd/out_ptr.hpp>
 
+#if !OS_WINDOWS
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#if OS_LINUX
+#include <cstring>
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#endif
+
 #include "enums.hpp"
 #include "os/errcheck.hpp"
 #include "utils/strings.hpp"
@@ -15,6 +27,25 @@ constexpr auto GetAddrInfoW = getaddrinfo;
 constexpr auto GetNameInfoW = getnameinfo;
 #endif
 
+#if OS_LINUX
+constexpr int fastOpenValue = 256; // Linux uses the value as the maximum number of pending Fast Open requests
+constexpr int deferAcceptTimeout = 5; // Seconds to wait for client data before a deferred accept gives up
+
+// Software receive timestamps. Transmit timestamps are requested for each send that needs one (see
+// Bidirectional::sendTimestamped), and are queued without a copy of the sent data.
+constexpr int timestampingFlags
+    = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_TSONLY;
+#else
+constexpr int fastOpenValue = 1; // Other platforms treat the value as a boolean
+#endif
+
+// Sets a socket option with a value of any type.
+template <class T>
+void setOption(Traits::SocketHandleType<SocketTag::IP> handle, int level, int name, T value) {
+    // The value is passed as a char pointer for compatibility with Winsock
+    check(setsockopt(handle, level, name, reinterpret_cast<const char*>(&value), sizeof(value)));
+}
+
 AddrInfoHandle NetUtils::resolveAddr(const Device& device, bool useDNS) {
     bool isUDP = device.type == ConnectionType::UDP;
     AddrInfoType hints{
@@ -66,6 +97,75 @@ std::uint16_t NetUtils::getPort(Traits::SocketHandleType<SocketTag::IP> handle,
     return UUIDs::byteSwap(port);
 }
 
+// Applies options that are valid on both connected and listening sockets.
+void setConnectionOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options, bool isTCP) {
+    // Buffer sizes are passed as int, zero keeps the system default
+    if (options.recvBufSize > 0) setOption(handle, SOL_SOCKET, SO_RCVBUF, static_cast<int>(options.recvBufSize));
+    if (options.sendBufSize > 0) setOption(handle, SOL_SOCKET, SO_SNDBUF, static_cast<int>(options.sendBufSize));
+
+    if (isTCP && options.noDelay) setOption(handle, IPPROTO_TCP, TCP_NODELAY, 1);
+
+#if OS_LINUX
+    // The kernel resets quick ACK mode on its own, so it is re-enabled after receives (see Bidirectional::recv)
+    if (isTCP && options.quickAck) setOption(handle, IPPROTO_TCP, TCP_QUICKACK, 1);
+
+    // Busy polling above net.core.busy_read requires CAP_NET_ADMIN
+    if (options.busyPoll > 0) setOption(handle, SOL_SOCKET, SO_BUSY_POLL, static_cast<int>(options.busyPoll));
+    if (options.maxPacingRate > 0) setOption(handle, SOL_SOCKET, SO_MAX_PACING_RATE, options.maxPacingRate);
+    if (options.timestamps) setOption(handle, SOL_SOCKET, SO_TIMESTAMPING, timestampingFlags);
+#endif
+}
+
+void NetUtils::setOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options) {
+    // Nothing to change if all options are default
+    if (options == SocketOptions{}) return;
+
+    // Check the socket type to avoid setting TCP options on datagram sockets
+    int type = 0;
+    socklen_t typeLen = sizeof(type);
+    check(getsockopt(handle, SOL_SOCKET, SO_TYPE, reinterpret_cast<char*>(&type), &typeLen));
+
+    setConnectionOptions(handle, options, type == SOCK_STREAM);
+}
+
+void NetUtils::setClientOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options,
+    bool isTCP) {
+    setConnectionOptions(handle, options, isTCP);
+
+#if OS_LINUX
+    // The connection is deferred until the first send, which then carries its data in the SYN.
+    // Other platforms need the data to be available at connect time, so client-side Fast Open is Linux-only.
+    if (isTCP && options.fastOpen) setOption(handle, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1);
+#endif
+}
+
+std::optional<SocketOptions> NetUtils::getAcceptedOptions([[maybe_unused]] const SocketOptions& listenerOptions) {
+#if OS_LINUX
+    // The kernel leaves quick ACK mode on its own, so it is not carried over to new connections
+    if (listenerOptions.quickAck) return SocketOptions{ .quickAck = true };
+#endif
+
+    // Other options are copied from the listener when a connection is accepted
+    return std::nullopt;
+}
+
+void NetUtils::setAcceptedOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options) {
+    setConnectionOptions(handle, options, true);
+}
+
+void NetUtils::setServerOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options,
+    bool isTCP) {
+    // Accepted sockets inherit these options from the listener
+    setConnectionOptions(handle, options, isTCP);
+    if (!isTCP) return;
+
+    if (options.fastOpen) setOption(handle, IPPROTO_TCP, TCP_FASTOPEN, fastOpenValue);
+
+#if OS_LINUX
+    if (options.deferAccept) setOption(handle, IPPROTO_TCP, TCP_DEFER_ACCEPT, deferAcceptTimeout);
+#endif
+}
+
 ServerAddress NetUtils::startServer(const Device& serverInfo, Delegates::SocketHandle<SocketTag::IP>& handle) {
     auto resolved = resolveAddr(serverInfo);
     bool isTCP = serverInfo.type == ConnectionType::TCP;
@@ -85,6 +185,7 @@ ServerAddress NetUtils::startServer(const Device& serverInfo, Delegates::SocketH
         }
 
         handle.reset(check(socket(result->ai_family, result->ai_socktype, result->ai_protocol)));
+        setServerOptions(*handle, handle.getOptions(), isTCP);
 
         // Bind and listen
         check(bind(*handle, result->ai_addr, static_cast<socklen_t>(result->ai_addrlen)));
@@ -93,3 +194,20 @@ ServerAddress NetUtils::startServer(const Device& serverInfo, Delegates::SocketH
 
     return { getPort(*handle, isV4), isV4 ? IPType::IPv4 : IPType::IPv6 };
 }
+
+#if OS_LINUX
+std::uint64_t NetUtils::getTimestamp(msghdr& msg) {
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPING) continue;
+
+        // The first timestamp is the software one, the others are for hardware timestamps
+        scm_timestamping timestamps;
+        std::memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(timestamps));
+
+        const timespec& ts = timestamps.ts[0];
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000 + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    return 0;
+}
+#endif
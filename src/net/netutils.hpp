@@ -3,7 +3,11 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
 #include <exception>
+#include <optional>
 #include <type_traits>
 
 #if OS_WINDOWS
@@ -78,6 +82,31 @@ namespace NetUtils {
     // Returns the port from a sockaddr.
     std::uint16_t getPort(Traits::SocketHandleType<SocketTag::IP> handle, bool isV4);
 
+    // Applies the options that can change on an open socket.
+    void setOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options);
+
+    // Applies options to a socket before it connects to a server.
+    void setClientOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options, bool isTCP);
+
+    // Gets the options that sockets accepted from a listener do not inherit from it, or an empty value if they inherit
+    // all of them.
+    std::optional<SocketOptions> getAcceptedOptions(const SocketOptions& listenerOptions);
+
+    // Applies options to a TCP socket after it is accepted.
+    void setAcceptedOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options);
+
+    // Applies options to a socket before it is bound and starts listening for clients.
+    void setServerOptions(Traits::SocketHandleType<SocketTag::IP> handle, const SocketOptions& options, bool isTCP);
+
     // Starts a server with the specified socket handle.
     ServerAddress startServer(const Device& serverInfo, Delegates::SocketHandle<SocketTag::IP>& handle);
+
+#if OS_LINUX
+    // Size of the control buffer needed to receive a timestamp with a message
+    constexpr std::size_t timestampControlSize = CMSG_SPACE(3 * sizeof(timespec));
+
+    // Gets the software timestamp from the control messages of a message received from a socket with the timestamps
+    // option, in nanoseconds since the Unix epoch. Returns 0 if the message has no timestamp.
+    std::uint64_t getTimestamp(msghdr& msg);
+#endif
 }
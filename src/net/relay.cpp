@@ -0,0 +1,202 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "relay.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if OS_WINDOWS
+#include <WinSock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#include "device.hpp"
+#include "enums.hpp"
+#include "os/error.hpp"
+#include "os/splice.hpp"
+#include "sockets/delegates/sockethandle.hpp"
+#include "sockets/staticsocket.hpp"
+#include "utils/task.hpp"
+
+// Maximum number of bytes to move at once (the default capacity of a pipe on Linux)
+constexpr std::size_t chunkSize = 65536;
+
+// A client connected to the target through the relay.
+struct Connection {
+    StaticIncomingSocket<SocketTag::IP> client;
+    StaticClientSocket<SocketTag::IP> target;
+    int openDirections = 2; // Directions that are still forwarding data
+
+    explicit Connection(Delegates::SocketHandle<SocketTag::IP>&& handle) : client(std::move(handle)) {}
+
+    // Cancels pending I/O on both sockets, ending both directions.
+    void cancel() {
+        client.cancelIO();
+        target.cancelIO();
+    }
+};
+
+struct Relay::State {
+    StaticServerSocket<SocketTag::IP> server;
+    Device target;
+    SocketOptions options;
+    LogFn log;
+    ServerAddress address;
+    RelayStats stats;
+    std::list<std::shared_ptr<Connection>> connections;
+    bool pendingAccept = false;
+    bool stopped = false;
+    bool useSplice = OS_LINUX;
+};
+
+// Passes a message to the relay's log, unless the relay has been stopped.
+void addLog(const Relay::State& state, std::string_view message, bool isError) {
+    if (state.log) state.log(message, isError);
+}
+
+// Shuts down the sending side of a socket, so its peer receives the end of the stream.
+void shutdownSend(const Delegates::SocketHandle<SocketTag::IP>& handle) {
+#if OS_WINDOWS
+    shutdown(*handle, SD_SEND);
+#else
+    shutdown(*handle, SHUT_WR);
+#endif
+}
+
+// Moves data from one socket to another until the source closes its connection.
+template <class From, class To>
+Task<> copyData(From& from, To& to, std::uint64_t& counter) {
+    while (true) {
+        auto recvResult = co_await from.recv(chunkSize);
+        if (recvResult.closed) co_return;
+
+        co_await to.send(recvResult.data);
+        counter += recvResult.data.size();
+    }
+}
+
+// Forwards data in one direction of a connection, then passes the end of the stream on.
+template <class From, class To>
+Task<> forwardData(From& from, To& to, std::uint64_t& counter, bool& useSplice) {
+#if OS_LINUX
+    if (useSplice) {
+        bool spliced = co_await Async::spliceData(*from.getHandle(), *to.getHandle(), counter);
+
+        // Splicing is unsupported on this kernel, so all following connections copy
+        if (!spliced) useSplice = false;
+    }
+#endif
+
+    if (!useSplice) co_await copyData(from, to, counter);
+    shutdownSend(to.getHandle());
+}
+
+// Runs one direction of a connection, and closes the connection once both directions have finished.
+Task<> forwardDirection(std::shared_ptr<Relay::State> state, std::shared_ptr<Connection> conn, bool toTarget) {
+    try {
+        if (toTarget) co_await forwardData(conn->client, conn->target, state->stats.toTarget, state->useSplice);
+        else co_await forwardData(conn->target, conn->client, state->stats.toClients, state->useSplice);
+    } catch (const System::SystemError& e) {
+        // An error in either direction ends the connection
+        if (!e.isCanceled()) addLog(*state, std::format("Connection error: {}", e.what()), true);
+        conn->cancel();
+    }
+
+    if (--conn->openDirections > 0) co_return;
+
+    conn->client.close();
+    conn->target.close();
+    state->stats.active--;
+}
+
+// Connects an accepted client to the target and starts forwarding its data.
+Task<> connectTarget(std::shared_ptr<Relay::State> state, std::shared_ptr<Connection> conn, Device device) {
+    try {
+        conn->target.setOptions(state->options);
+        co_await conn->target.connect(state->target);
+    } catch (const System::SystemError& e) {
+        if (!e.isCanceled())
+            addLog(*state, std::format("Could not connect {} to the target: {}", device.address, e.what()), true);
+
+        conn->client.close();
+        conn->openDirections = 0;
+        co_return;
+    }
+
+    state->stats.active++;
+    spawn(forwardDirection(state, conn, true));
+    spawn(forwardDirection(state, conn, false));
+}
+
+// Accepts a client and connects it to the target.
+Task<> acceptClient(std::shared_ptr<Relay::State> state) {
+    try {
+        auto [device, handle] = co_await state->server.accept();
+        state->pendingAccept = false;
+        state->stats.accepted++;
+        addLog(*state, std::format("Accepted connection from {} on port {}.", device.address, device.port), false);
+
+        auto conn = std::make_shared<Connection>(std::move(handle));
+        state->connections.push_back(conn);
+        spawn(connectTarget(state, conn, device));
+    } catch (const System::SystemError& e) {
+        state->pendingAccept = false;
+        if (!e.isCanceled()) addLog(*state, std::format("Accept error: {}", e.what()), true);
+    }
+}
+
+Relay::Relay(const Device& serverInfo, const Device& target, const SocketOptions& options, LogFn log) :
+    state(std::make_shared<State>()) {
+    state->target = target;
+    state->options = options;
+    state->log = std::move(log);
+
+    state->server.setOptions(options);
+    state->address = state->server.startServer(serverInfo);
+}
+
+Relay::~Relay() {
+    stop();
+}
+
+ServerAddress Relay::getAddress() const {
+    return state->address;
+}
+
+void Relay::update() {
+    std::erase_if(state->connections, [](const auto& conn) { return conn->openDirections == 0; });
+
+    if (state->stopped || state->pendingAccept) return;
+
+    state->pendingAccept = true;
+    spawn(acceptClient(state));
+}
+
+void Relay::stop() {
+    if (state->stopped) return;
+    state->stopped = true;
+
+    // Coroutines can finish after the relay is destroyed, so they must not use its owner's log
+    state->log = nullptr;
+
+    // Pending operations are canceled before their sockets are closed
+    state->server.cancelIO();
+    state->server.close();
+    for (const auto& conn : state->connections) conn->cancel();
+}
+
+const RelayStats& Relay::getStats() const {
+    return state->stats;
+}
+
+bool Relay::usesSplice() const {
+    return state->useSplice;
+}
@@ -0,0 +1,65 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "device.hpp"
+#include "sockets/delegates/delegates.hpp"
+
+// Counters of a relay.
+struct RelayStats {
+    std::uint64_t toTarget = 0; // Bytes moved from clients to the target
+    std::uint64_t toClients = 0; // Bytes moved from the target to clients
+    std::uint64_t accepted = 0; // Clients accepted
+    std::uint64_t active = 0; // Clients currently connected to the target
+};
+
+// Forwards TCP connections accepted by a local server to a target host, moving data in both directions until both
+// sides have closed their connections.
+//
+// On Linux, data is spliced through a pipe so it is not copied through user space. Other platforms (and kernels that
+// cannot splice with io_uring) copy the data with sends and receives. All work runs on the thread calling update().
+class Relay {
+public:
+    // Receives messages about connections. Errors are passed with isError set.
+    using LogFn = std::function<void(std::string_view message, bool isError)>;
+
+    // State shared with the coroutines forwarding data, which can outlive the relay.
+    struct State;
+
+private:
+    std::shared_ptr<State> state;
+
+public:
+    // Starts the server that accepts clients. Throws if it cannot be started.
+    Relay(const Device& serverInfo, const Device& target, const SocketOptions& options, LogFn log);
+
+    // Stops the relay.
+    ~Relay();
+
+    Relay(const Relay&) = delete;
+
+    Relay& operator=(const Relay&) = delete;
+
+    // Gets the address that the server is bound to.
+    ServerAddress getAddress() const;
+
+    // Accepts the next client if no accept is pending, and removes finished connections.
+    // Must be called regularly from the thread running the relay.
+    void update();
+
+    // Closes the server and all connections.
+    void stop();
+
+    // Gets the byte and connection counters.
+    const RelayStats& getStats() const;
+
+    // Checks if data is being spliced instead of copied.
+    // This is only accurate once data has been forwarded, since the first splice can find that it is unsupported.
+    bool usesSplice() const;
+};
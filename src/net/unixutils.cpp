@@ -0,0 +1,93 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "unixutils.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <format>
+
+#include <unistd.h>
+
+#include "os/errcheck.hpp"
+#include "os/error.hpp"
+
+// Offset of the path in a socket address
+constexpr socklen_t pathOffset = offsetof(sockaddr_un, sun_path);
+
+// Checks if a socket file was left behind by a server that is no longer running.
+bool isStale(const UnixUtils::Address& addr, int type) {
+    Delegates::SocketHandle<SocketTag::Unix> probe{ socket(AF_UNIX, type, 0) };
+    if (!probe.isValid()) return false;
+
+    return connect(*probe, reinterpret_cast<const sockaddr*>(&addr.addr), addr.len) == -1 && errno == ECONNREFUSED;
+}
+
+UnixUtils::Address UnixUtils::toAddr(std::string_view path) {
+    Address result;
+    result.addr.sun_family = AF_UNIX;
+
+    // Abstract names start with a null byte instead of '@' and are not null-terminated.
+    // Filesystem paths need space for a null terminator.
+    bool isAbstract = OS_LINUX && path.starts_with('@');
+    std::size_t maxLen = sizeof(result.addr.sun_path) - (isAbstract ? 0 : 1);
+    if (path.size() > maxLen) throw System::SystemError{ ENAMETOOLONG, System::ErrorType::System };
+
+    path.copy(result.addr.sun_path, path.size());
+    if (isAbstract) result.addr.sun_path[0] = '\0';
+
+    result.len = pathOffset + static_cast<socklen_t>(path.size()) + (isAbstract ? 0 : 1);
+    return result;
+}
+
+std::string UnixUtils::fromAddr(const Address& addr) {
+    // Unbound sockets have no path
+    if (addr.len <= pathOffset) return "";
+
+    const char* path = addr.addr.sun_path;
+    std::size_t len = addr.len - pathOffset;
+    if (path[0] == '\0') return std::format("@{}", std::string_view{ path + 1, len - 1 });
+
+    return { path, strnlen(path, len) };
+}
+
+int UnixUtils::getSocketType(ConnectionType type) {
+    return type == ConnectionType::UnixSeqPacket ? SOCK_SEQPACKET : SOCK_STREAM;
+}
+
+Device UnixUtils::getPeer(Traits::SocketHandleType<SocketTag::Unix> handle, const Address& addr,
+    ConnectionType type) {
+    Device device{ type, "", fromAddr(addr), 0 };
+    if (!device.address.empty()) return device;
+
+#if OS_LINUX
+    ucred cred;
+    socklen_t credLen = sizeof(cred);
+    if (getsockopt(handle, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) == 0)
+        device.address = std::format("PID {}", cred.pid);
+#elif OS_MACOS
+    pid_t pid;
+    socklen_t pidLen = sizeof(pid);
+    if (getsockopt(handle, SOL_LOCAL, LOCAL_PEERPID, &pid, &pidLen) == 0) device.address = std::format("PID {}", pid);
+#endif
+
+    return device;
+}
+
+ServerAddress UnixUtils::startServer(const Device& serverInfo, Delegates::SocketHandle<SocketTag::Unix>& handle) {
+    Address addr = toAddr(serverInfo.address);
+    auto sockAddr = reinterpret_cast<const sockaddr*>(&addr.addr);
+    int type = getSocketType(serverInfo.type);
+
+    handle.reset(check(socket(AF_UNIX, type, 0)));
+
+    // Replace socket files from previous servers that were not removed
+    if (bind(*handle, sockAddr, addr.len) == -1) {
+        if (errno == EADDRINUSE && addr.addr.sun_path[0] != '\0' && isStale(addr, type)) unlink(addr.addr.sun_path);
+        check(bind(*handle, sockAddr, addr.len));
+    }
+
+    check(listen(*handle, SOMAXCONN));
+    return { 0, IPType::None };
+}
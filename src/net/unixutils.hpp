@@ -0,0 +1,42 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "device.hpp"
+#include "enums.hpp"
+#include "sockets/delegates/delegates.hpp"
+#include "sockets/delegates/sockethandle.hpp"
+#include "sockets/delegates/traits.hpp"
+
+// Unix domain sockets are not available on Windows.
+namespace UnixUtils {
+    // Unix domain socket address and its length.
+    struct Address {
+        sockaddr_un addr{};
+        socklen_t len = sizeof(sockaddr_un);
+    };
+
+    // Converts a path to a socket address.
+    // Paths starting with '@' are names in the abstract namespace (Linux only).
+    Address toAddr(std::string_view path);
+
+    // Converts a socket address to a path, using the same '@' prefix for abstract names.
+    std::string fromAddr(const Address& addr);
+
+    // Gets the socket type (stream or sequenced-packet) to use for a connection type.
+    int getSocketType(ConnectionType type);
+
+    // Gets information about a client accepted from a server.
+    // Clients are usually unbound, so they are identified by their process ID where the system provides it.
+    Device getPeer(Traits::SocketHandleType<SocketTag::Unix> handle, const Address& addr, ConnectionType type);
+
+    // Starts a server with the specified socket handle.
+    ServerAddress startServer(const Device& serverInfo, Delegates::SocketHandle<SocketTag::Unix>& handle);
+}
@@ -4,26 +4,37 @@
 #include "async.hpp"
 
 #include <atomic>
-#include <chrono>
+#include <cerrno>
+#include <condition_variable>
 #include <coroutine>
+#include <deque>
+#include <exception>
 #include <forward_list>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <stdexcept>
 #include <thread>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#include "error.hpp"
+#include "offload.hpp"
 #include "utils/task.hpp"
 
 class WorkerThread {
     unsigned int queueEntries;
+    Async::Backend backend;
+    unsigned int busyPoll;
 
     std::vector<std::coroutine_handle<>> workQueue;
     std::mutex queueMutex;
     std::atomic_size_t numWork = 0;
     std::atomic_bool hasWork = false;
     std::atomic_bool shouldStop = false;
+    std::atomic_bool ready = false; // If the event loop has been created
 
     std::unique_ptr<Async::EventLoop> eventLoop;
     std::thread thread;
@@ -31,15 +42,28 @@ class WorkerThread {
 
     void loop();
 
-    void stop() {
-        shouldStop.store(true, std::memory_order_relaxed);
+    // Resumes the coroutines posted to this thread.
+    void runWork();
+
+    // Wakes the thread, whether it is idle or waiting for I/O.
+    void notify() {
         hasWork.store(true, std::memory_order_relaxed);
         hasWork.notify_one();
+        if (std::this_thread::get_id() != id) eventLoop->wake();
+    }
+
+    void stop() {
+        shouldStop.store(true, std::memory_order_relaxed);
+        notify();
     }
 
 public:
-    WorkerThread(unsigned int queueEntries) :
-        queueEntries(queueEntries), thread(&WorkerThread::loop, this), id(thread.get_id()) {}
+    WorkerThread(unsigned int queueEntries, Async::Backend backend, unsigned int busyPoll) :
+        queueEntries(queueEntries), backend(backend), busyPoll(busyPoll), thread(&WorkerThread::loop, this),
+        id(thread.get_id()) {
+        // Other threads can post work as soon as this returns, which needs the event loop
+        ready.wait(false);
+    }
 
     ~WorkerThread() {
         stop();
@@ -52,14 +76,14 @@ public:
             workQueue.push_back(handle);
         }
         numWork.fetch_add(1, std::memory_order_relaxed);
-        hasWork.store(true, std::memory_order_relaxed);
-        hasWork.notify_one();
+        notify();
     }
 
     void pushIO(const Async::Operation& operation) {
-        eventLoop->push(operation);
-        hasWork.store(true, std::memory_order_relaxed);
-        hasWork.notify_one();
+        if (std::this_thread::get_id() == id) eventLoop->push(operation);
+        else eventLoop->pushRemote(operation);
+
+        notify();
     }
 
     std::size_t size() const {
@@ -75,128 +99,334 @@ void WorkerThread::loop() {
     // Initialize event loop on this thread (needed for single issuer optimization on Linux)
     // numThreads in an event loop constructor is only used on Windows, and only with the first instantiation.
     // Since the main event loop is initialized first, 0 is passed here to avoid storing another value in this class.
-    eventLoop = std::make_unique<Async::EventLoop>(0, queueEntries);
+    eventLoop = std::make_unique<Async::EventLoop>(0, queueEntries, backend, busyPoll);
+    ready.store(true);
+    ready.notify_one();
 
     while (true) {
+        // Make thread idle to save CPU cycles if there is no I/O to wait for
+        // Otherwise, the event loop waits for I/O, and work posted from other threads wakes it.
         bool expected = true;
-        if (!hasWork.compare_exchange_weak(expected, false, std::memory_order_relaxed)) {
-            if (eventLoop->size() == 0) {
-                // Make thread idle to save CPU cycles
-                hasWork.wait(false, std::memory_order_relaxed);
-            } else {
-                // There are outstanding I/O events, check back periodically
-                using namespace std::literals;
-                std::this_thread::sleep_for(200ms);
-            }
-        }
-
-        if (shouldStop.load(std::memory_order_relaxed)) break;
+        if (!hasWork.compare_exchange_weak(expected, false, std::memory_order_relaxed) && eventLoop->size() == 0)
+            hasWork.wait(false, std::memory_order_relaxed);
 
-        eventLoop->runOnce();
-
-        // Swap the work queue with an empty queue. This performs the following actions:
-        //   - Clears the work queue
-        //   - Makes the data isolated from other threads so the mutex can be locked for minimal time
-        //   - Consumes less memory compared to a full copy
+        // Coroutines posted before stopping are still resumed (e.g. ones whose offload jobs were failed by cleanup())
+        if (shouldStop.load(std::memory_order_relaxed)) {
+            runWork();
+            break;
+        }
 
-        std::vector<std::coroutine_handle<>> tmp;
+        // Posted coroutines are not left waiting for I/O
+        bool posted;
         {
             std::scoped_lock lock{ queueMutex };
-            std::swap(tmp, workQueue);
+            posted = !workQueue.empty();
         }
+        eventLoop->runOnce(!posted);
+        runWork();
+    }
+}
 
-        for (const auto& i : tmp) {
-            i();
-            numWork.fetch_sub(1, std::memory_order_relaxed);
-        }
+void WorkerThread::runWork() {
+    // Swap the work queue with an empty queue. This performs the following actions:
+    //   - Clears the work queue
+    //   - Makes the data isolated from other threads so the mutex can be locked for minimal time
+    //   - Consumes less memory compared to a full copy
+
+    std::vector<std::coroutine_handle<>> tmp;
+    {
+        std::scoped_lock lock{ queueMutex };
+        std::swap(tmp, workQueue);
+    }
+
+    for (const auto& i : tmp) {
+        i();
+        numWork.fetch_sub(1, std::memory_order_relaxed);
     }
 }
 
 using WorkerThreadPool = std::forward_list<WorkerThread>;
 WorkerThreadPool threads;
 std::optional<Async::EventLoop> eventLoop;
+std::thread::id mainThread; // The thread that called init()
+
+// Coroutines posted to the main thread from any thread
+std::vector<std::coroutine_handle<>> mainQueue;
+std::mutex mainQueueMutex;
+
+// Threads that run blocking work for offload(), started when they are needed
+constexpr std::size_t maxOffloadThreads = 4;
+std::vector<std::thread> offloadThreads;
+std::deque<Async::OffloadJob*> offloadJobs;
+std::mutex offloadMutex;
+std::condition_variable offloadCond;
+std::size_t idleOffloadThreads = 0;
+bool stopOffload = false;
+
+// Resumes the coroutines posted to the main thread.
+void runMainQueue() {
+    // The queue is swapped out since resumed coroutines can post more work
+    std::vector<std::coroutine_handle<>> tmp;
+    {
+        std::scoped_lock lock{ mainQueueMutex };
+        std::swap(tmp, mainQueue);
+    }
+
+    for (const auto& i : tmp) i();
+}
 
-Task<> queueFnToThread(WorkerThread& thread, std::function<Task<bool>()> f) {
-    Async::CompletionResult result;
-    co_await result;
+void runOffloadJobs() {
+    std::unique_lock lock{ offloadMutex };
+    while (true) {
+        idleOffloadThreads++;
+        offloadCond.wait(lock, [] { return stopOffload || !offloadJobs.empty(); });
+        idleOffloadThreads--;
 
-    // Copy the given function to preserve it when the coroutine is resumed
-    auto tmp = f;
+        // Jobs still queued when stopping are failed by cleanup()
+        if (stopOffload) return;
 
-    thread.push(result.coroHandle);
-    co_await std::suspend_always{};
+        Async::OffloadJob* job = offloadJobs.front();
+        offloadJobs.pop_front();
 
-    if (co_await tmp()) co_await queueFnToThread(thread, tmp);
+        lock.unlock();
+        job->run();
+        lock.lock();
+    }
 }
 
-unsigned int Async::init(unsigned int numThreads, unsigned int queueEntries) {
+Task<> queueFnToThread(Async::Executor executor, std::function<Task<bool>()> f) {
+    // Each run is queued again so other work on the thread can run in between
+    bool requeue = true;
+    while (requeue) {
+        co_await Async::resumeOn(executor);
+        requeue = co_await f();
+    }
+}
+
+unsigned int Async::init(unsigned int numThreads, unsigned int queueEntries, Backend backend, unsigned int busyPoll) {
     // If 0 threads are specified, the number is chosen with hardware_concurrency.
     // If the number of supported threads cannot be determined, no worker threads are created.
     // The number of threads created is (desired number) - 1 since the main thread also runs an event loop.
     unsigned int realNumThreads = numThreads == 0 ? std::max(std::thread::hardware_concurrency(), 1U) : numThreads;
-    eventLoop.emplace(realNumThreads, queueEntries);
+    mainThread = std::this_thread::get_id();
+    eventLoop.emplace(realNumThreads, queueEntries, backend, busyPoll);
 
+    // Worker threads use the backend that the main event loop settled on
     if (realNumThreads > 1)
-        for (unsigned int i = 0; i < realNumThreads - 1; i++) threads.emplace_front(queueEntries);
+        for (unsigned int i = 0; i < realNumThreads - 1; i++)
+            threads.emplace_front(queueEntries, eventLoop->getBackend(), busyPoll);
 
     return realNumThreads;
 }
 
+Async::Backend Async::getBackend() {
+    return eventLoop ? eventLoop->getBackend() : Backend::Auto;
+}
+
+std::vector<Async::Capability> Async::getCapabilities() {
+    return eventLoop ? eventLoop->getCapabilities() : std::vector<Capability>{};
+}
+
 void Async::cleanup() {
+    {
+        std::scoped_lock lock{ offloadMutex };
+        stopOffload = true;
+    }
+    offloadCond.notify_all();
+
+    // Running jobs are waited for, since they resume coroutines on the event loops
+    for (auto& i : offloadThreads) i.join();
+    offloadThreads.clear();
+
+    // Jobs that did not start are failed with the error of a canceled operation, so their coroutines end instead of
+    // being left suspended
+#if OS_WINDOWS
+    auto canceled = std::make_exception_ptr(System::SystemError{ WSA_OPERATION_ABORTED, System::ErrorType::System });
+#else
+    auto canceled = std::make_exception_ptr(System::SystemError{ ECANCELED, System::ErrorType::System });
+#endif
+    for (auto job : offloadJobs) job->fail(canceled);
+    offloadJobs.clear();
+    stopOffload = false;
+
+    // Worker threads resume the coroutines posted to them before they stop, the rest are resumed here
     threads.clear();
+    runMainQueue();
+}
+
+void Async::EventLoop::pushRemote(const Operation& operation) {
+    {
+        std::scoped_lock lock{ inboxMutex };
+        inbox.push_back(operation);
+        hasInbox.store(true);
+    }
+    wake();
+}
+
+void Async::EventLoop::wake() {
+    // Only the first wakeup signals the OS, the loop handles everything queued before it clears the flag
+    if (!wakePending.exchange(true)) signalWake();
+}
+
+void Async::EventLoop::takeInbox() {
+    if (!hasInbox.exchange(false)) return;
+
+    std::scoped_lock lock{ inboxMutex };
+    for (const auto& i : inbox) operations.push_back(i);
+    inbox.clear();
 }
 
 void Async::submit(const Operation& op) {
-    std::thread::id currentThread = std::this_thread::get_id();
+    submit(getCurrentExecutor(), op);
+}
 
-    // Push I/O to the worker thread that corresponds to the thread this function is running on
-    // A coroutine will never leave a thread and will resume on the thread it suspended on.
-    for (auto i = threads.begin(); i != threads.end(); i++) {
-        if (i->getID() == currentThread) {
-            i->pushIO(op);
-            return;
-        }
-    }
+void Async::submit(Executor executor, const Operation& op) {
+    // Find the worker thread of the executor. If there is none, the operation goes to the main event loop.
+    // A coroutine that awaits an operation is resumed on the thread whose event loop completes it.
+    auto worker = threads.begin();
+    while (worker != threads.end() && worker->getID() != executor.getThreadID()) worker++;
+
+    std::thread::id owner = worker == threads.end() ? mainThread : worker->getID();
+
+    // Record the handle and owner so the operation can be canceled by itself later
+    std::visit(
+        [owner](const OperationBase& base) {
+            if (!base.result) return;
 
-    // If there is no corresponding worker thread, the operation was submitted in the main event loop
-    eventLoop->push(op);
+            if (base.result->cancelable && owner != std::this_thread::get_id())
+                throw std::invalid_argument{ "Operations that can be canceled must stay on the awaiting thread" };
+
+            base.result->handle = base.handle;
+            base.result->owner = owner;
+        },
+        op);
+
+    if (worker != threads.end()) worker->pushIO(op);
+    else if (std::this_thread::get_id() == mainThread) eventLoop->push(op);
+    else eventLoop->pushRemote(op);
+}
+
+Async::Executor Async::getMainExecutor() {
+    return Executor{ mainThread };
 }
 
-Task<> Async::queueToThread() {
-    CompletionResult result;
-    co_await result;
+std::vector<Async::Executor> Async::getWorkerExecutors() {
+    std::vector<Executor> executors;
+    for (const auto& i : threads) executors.emplace_back(i.getID());
+    return executors;
+}
 
-    WorkerThreadPool::iterator least;
-    auto leastCount = std::numeric_limits<std::size_t>::max();
+Async::ResumeOn Async::queueToThread() {
+    if (threads.empty()) return resumeOn(getMainExecutor());
 
+    auto least = threads.begin();
     for (auto i = threads.begin(); i != threads.end(); i++) {
         std::size_t size = i->size();
 
         // Immediately add work to any thread that is idle and waiting for work
-        if (size == 0) {
-            i->push(result.coroHandle);
-            co_await std::suspend_always{};
-            co_return;
-        }
+        if (size == 0) return resumeOn(Executor{ i->getID() });
 
-        if (size < leastCount) {
-            leastCount = size;
-            least = i;
-        }
+        // Otherwise, pick the one with the least amount of work for even work distribution
+        if (size < least->size()) least = i;
     }
 
-    // If no threads are idle, push to the one with the least amount of work for even work distribution
-    least->push(result.coroHandle);
-    co_await std::suspend_always{};
+    return resumeOn(Executor{ least->getID() });
 }
 
 void Async::queueToThreadEx(std::thread::id id, std::function<Task<bool>()> f) {
     bool allThreads = id == std::thread::id{};
 
     for (auto i = threads.begin(); i != threads.end(); i++)
-        if (allThreads || i->getID() == id) queueFnToThread(*i, f);
+        if (allThreads || i->getID() == id) spawn(queueFnToThread(Executor{ i->getID() }, f));
+}
+
+void Async::post(std::thread::id id, std::coroutine_handle<> handle) {
+    for (auto i = threads.begin(); i != threads.end(); i++) {
+        if (i->getID() == id) {
+            i->push(handle);
+            return;
+        }
+    }
+
+    {
+        std::scoped_lock lock{ mainQueueMutex };
+        mainQueue.push_back(handle);
+    }
+
+    // The main thread can be waiting for I/O in handleEvents
+    if (std::this_thread::get_id() != mainThread) eventLoop->wake();
+}
+
+void Async::queueOffload(OffloadJob& job) {
+    {
+        std::scoped_lock lock{ offloadMutex };
+
+        // Start another thread if the job would otherwise wait behind others
+        // This is done first so the job is not left in the queue if the thread cannot be started.
+        if (offloadJobs.size() >= idleOffloadThreads && offloadThreads.size() < maxOffloadThreads)
+            offloadThreads.emplace_back(runOffloadJobs);
+
+        offloadJobs.push_back(&job);
+    }
+    offloadCond.notify_one();
 }
 
 void Async::handleEvents(bool wait) {
-    eventLoop->runOnce(wait);
+    // Posted coroutines are not left waiting for I/O
+    bool posted;
+    {
+        std::scoped_lock lock{ mainQueueMutex };
+        posted = !mainQueue.empty();
+    }
+    eventLoop->runOnce(wait && !posted);
+    runMainQueue();
+}
+
+#if !OS_WINDOWS
+Async::Poller::~Poller() {
+    if (!state->armed) {
+        delete state;
+        return;
+    }
+
+    // A pending poll still refers to the state, so it is freed once the poll ends
+    state->orphaned = true;
+    cancel();
+}
+
+Task<int> Async::Poller::next() {
+    // The state is kept here since it can outlive this object if it is destroyed during the wait
+    PollResult& result = *state;
+
+    if (result.events == 0 && result.error == 0) {
+        result.coroHandle = nullptr;
+        co_await result;
+
+        if (!result.armed) {
+            result.armed = true;
+            submit(Poll{ { fd, &result }, write, true });
+        }
+
+        result.waiting = true;
+        co_await std::suspend_always{};
+
+        // Backends without multishot polls complete them like other operations, so the waiting flag is not cleared
+        if (result.waiting) {
+            result.waiting = false;
+            result.armed = false;
+            if (result.error == 0) result.events = result.res;
+        }
+    }
+
+    int events = std::exchange(result.events, 0);
+    System::ErrorCode error = std::exchange(result.error, 0);
+
+    if (result.orphaned) {
+        delete &result;
+        error = ECANCELED;
+    }
+
+    if (error != 0) throw System::SystemError{ error, System::ErrorType::System };
+    co_return events;
 }
+#endif
@@ -0,0 +1,298 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Epoll backend for Linux, used where io_uring is unavailable.
+// Completion-based operations are emulated by attempting each operation as soon as it is submitted, then retrying it
+// when epoll reports that its socket is ready.
+
+#include "async.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "errcheck.hpp"
+#include "fileops.hpp"
+#include "utils/overload.hpp"
+
+// Maximum number of events to get from epoll at once
+constexpr int maxEvents = 64;
+
+// Gets the completion result of an operation.
+Async::CompletionResult* getResult(const Async::Operation& op) {
+    return std::visit([](const Async::OperationBase& base) { return base.result; }, op);
+}
+
+// Gets the socket of an operation.
+int getHandle(const Async::Operation& op) {
+    return std::visit([](const Async::OperationBase& base) { return base.handle; }, op);
+}
+
+// Checks if an operation waits for a socket to become readable (as opposed to writable).
+bool isRead(const Async::Operation& op) {
+    if (auto poll = std::get_if<Async::Poll>(&op)) return !poll->write;
+    if (auto splice = std::get_if<Async::Splice>(&op)) return splice->toPipe;
+
+    return std::holds_alternative<Async::Accept>(op) || std::holds_alternative<Async::Receive>(op)
+        || std::holds_alternative<Async::ReceiveFrom>(op);
+}
+
+// Gets the queue of a socket's pending operations that an operation waits in.
+std::deque<Async::Operation>& getQueue(Async::EpollPending& pending, const Async::Operation& op) {
+    if (auto poll = std::get_if<Async::Poll>(&op); poll && poll->errors) return pending.errors;
+    return isRead(op) ? pending.reads : pending.writes;
+}
+
+// Makes a socket nonblocking so connect and accept calls do not block the event loop.
+void makeNonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags != -1 && !(flags & O_NONBLOCK)) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Attempts an operation, then stores its result and returns true if it did not need to wait for the socket.
+// Connect operations check their status instead of starting a new connection if the socket is ready.
+bool tryOperation(const Async::Operation& operation, bool ready) {
+    ssize_t rc = 0;
+
+    Overload visitor{
+        [&](const Async::Connect& op) {
+            if (!ready) {
+                makeNonblocking(op.handle);
+                rc = connect(op.handle, op.addr, op.addrLen);
+                if (rc == -1 && errno == EINPROGRESS) errno = EAGAIN;
+                return;
+            }
+
+            int error = 0;
+            socklen_t errorLen = sizeof(error);
+            rc = getsockopt(op.handle, SOL_SOCKET, SO_ERROR, &error, &errorLen);
+            if (rc == 0 && error != 0) {
+                rc = -1;
+                errno = error;
+            }
+        },
+        [&](const Async::Accept& op) {
+            makeNonblocking(op.handle);
+            rc = accept4(op.handle, op.addr, op.addrLen, SOCK_CLOEXEC);
+        },
+        [&](const Async::Send& op) {
+            rc = send(op.handle, op.data.data(), op.data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        },
+        [&](const Async::SendTo& op) {
+            rc = sendto(op.handle, op.data.data(), op.data.size(), MSG_NOSIGNAL | MSG_DONTWAIT, op.addr, op.addrLen);
+        },
+        [&](const Async::Receive& op) {
+            rc = recv(op.handle, op.data.data(), op.data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        },
+        [&](const Async::ReceiveFrom& op) { rc = recvmsg(op.handle, op.msg, MSG_NOSIGNAL | MSG_DONTWAIT); },
+        [&](const Async::Splice& op) {
+            // The pipe is drained before it is filled again, so only the socket can make the splice wait
+            makeNonblocking(op.handle);
+            int in = op.toPipe ? op.handle : op.pipe;
+            int out = op.toPipe ? op.pipe : op.handle;
+            loff_t offset = op.offset;
+            loff_t* inOffset = op.toPipe && offset >= 0 ? &offset : nullptr;
+            rc = splice(in, inOffset, out, nullptr, op.size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        },
+        [&](const Async::Poll& op) {
+            // Multishot polls are not emulated, every poll completes after its first event
+            // Errors and hangups are always reported, so error polls do not request any other events
+            short events = op.errors ? 0 : op.write ? POLLOUT : POLLIN;
+            pollfd fd{ op.handle, events, 0 };
+            rc = poll(&fd, 1, 0);
+            if (rc == 0) errno = EAGAIN;
+            rc = rc > 0 ? fd.revents : -1;
+        },
+        [](const auto&) {},
+    };
+
+    std::visit(visitor, operation);
+    if (rc == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+
+    auto& result = *getResult(operation);
+    if (rc == -1) result.error = errno;
+    else result.res = static_cast<int>(rc);
+
+    return true;
+}
+
+bool Async::EventLoop::handleEpollOperation(const Operation& operation) {
+    // Disk I/O is always reported as ready by epoll, so file operations are run immediately
+    if (runFileOperation(operation)) {
+        auto result = getResult(operation);
+        if (result) result->coroHandle();
+        return result != nullptr;
+    }
+
+    int fd = getHandle(operation);
+    bool resumed = false;
+
+    Overload visitor{
+        [fd](const Shutdown&) { shutdown(fd, SHUT_RDWR); },
+        [this, fd](const Close&) {
+            cancelEpollOperations(fd);
+            close(fd);
+        },
+        [this, fd](const Cancel&) { cancelEpollOperations(fd); },
+        [this, fd](const CancelOperation& op) { cancelEpollOperation(fd, op.target); },
+        [this, fd, &operation, &resumed](const auto&) {
+            // Operations wait behind others in the same direction to keep their order
+            auto it = epollPending.find(fd);
+            bool hasQueued = it != epollPending.end() && !getQueue(it->second, operation).empty();
+
+            if (!hasQueued && tryOperation(operation, false)) {
+                getResult(operation)->coroHandle();
+                resumed = true;
+                return;
+            }
+
+            getQueue(epollPending[fd], operation).push_back(operation);
+            numOperations++;
+            updateEpollInterest(fd);
+        },
+    };
+
+    std::visit(visitor, operation);
+    return resumed;
+}
+
+void Async::EventLoop::retryEpollOperations(int fd, bool read, bool write, bool error) {
+    auto it = epollPending.find(fd);
+    if (it == epollPending.end()) return;
+
+    // Results are resumed after the pending operations are updated since the resumed coroutines can submit more
+    std::vector<CompletionResult*> completed;
+    auto retry = [&](std::deque<Operation>& queue) {
+        while (!queue.empty() && tryOperation(queue.front(), true)) {
+            completed.push_back(getResult(queue.front()));
+            queue.pop_front();
+            numOperations--;
+        }
+    };
+
+    if (read) retry(it->second.reads);
+    if (write) retry(it->second.writes);
+    if (error) retry(it->second.errors);
+    updateEpollInterest(fd);
+
+    for (auto result : completed) result->coroHandle();
+}
+
+void Async::EventLoop::cancelEpollOperations(int fd) {
+    auto node = epollPending.extract(fd);
+    if (node.empty()) return;
+
+    // Sockets must be removed from epoll before they are closed
+    auto& pending = node.mapped();
+    if (pending.registered) epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+
+    std::vector<CompletionResult*> canceled;
+    for (auto queue : { &pending.reads, &pending.writes, &pending.errors })
+        for (const auto& op : *queue) canceled.push_back(getResult(op));
+
+    numOperations -= canceled.size();
+    for (auto result : canceled) {
+        result->error = ECANCELED;
+        result->coroHandle();
+    }
+}
+
+void Async::EventLoop::cancelEpollOperation(int fd, CompletionResult* target) {
+    auto it = epollPending.find(fd);
+    if (it == epollPending.end()) return;
+
+    // The target is only dereferenced once it is found, since it may have completed and been destroyed
+    for (auto queue : { &it->second.reads, &it->second.writes, &it->second.errors }) {
+        // Operations cannot be assigned (they hold references), so the queue is rebuilt without the target
+        std::deque<Operation> remaining;
+        for (const auto& op : *queue)
+            if (getResult(op) != target) remaining.push_back(op);
+
+        if (remaining.size() == queue->size()) continue;
+
+        queue->swap(remaining);
+        numOperations--;
+        updateEpollInterest(fd);
+
+        target->error = ECANCELED;
+        target->coroHandle();
+        return;
+    }
+}
+
+void Async::EventLoop::updateEpollInterest(int fd) {
+    auto it = epollPending.find(fd);
+    if (it == epollPending.end()) return;
+
+    auto& pending = it->second;
+    std::uint32_t events = 0;
+    if (!pending.reads.empty()) events |= EPOLLIN;
+    if (!pending.writes.empty()) events |= EPOLLOUT;
+
+    // Remove sockets that have nothing left to wait for (errors are always reported, so they need no events)
+    if (events == 0 && pending.errors.empty()) {
+        if (pending.registered) epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+        epollPending.erase(it);
+        return;
+    }
+
+    epoll_event event{ .events = events, .data = { .fd = fd } };
+    if (epoll_ctl(epfd, pending.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) == 0) {
+        pending.registered = true;
+        return;
+    }
+
+    // The socket cannot be waited on (e.g. it was closed), so its operations fail with the error
+    int error = errno;
+    std::vector<CompletionResult*> failed;
+    for (auto queue : { &pending.reads, &pending.writes, &pending.errors })
+        for (const auto& op : *queue) failed.push_back(getResult(op));
+
+    numOperations -= failed.size();
+    epollPending.erase(it);
+
+    for (auto result : failed) {
+        result->error = error;
+        result->coroHandle();
+    }
+}
+
+bool Async::EventLoop::runOnceEpoll(bool wait) {
+    // Resumed coroutines can submit operations, so the queue is swapped out before it is processed
+    std::vector<Operation> queued;
+    std::swap(queued, operations);
+
+    bool resumed = false;
+    for (const auto& i : queued) resumed |= handleEpollOperation(i);
+
+    if (numOperations == 0) return !queued.empty();
+
+    // Coroutines resumed by operations that completed immediately can have submitted more operations (e.g. a send
+    // after a receive) or finished work that the caller is waiting for, so they are not stalled by a wait
+    std::array<epoll_event, maxEvents> events;
+    int numEvents = epoll_wait(epfd, events.data(), maxEvents, wait && !resumed && operations.empty() ? 200 : 0);
+
+    for (int i = 0; i < numEvents; i++) {
+        if (events[i].data.fd == wakeFd) {
+            clearWake();
+            continue;
+        }
+
+        // Errors and hangups are reported to operations in both directions by retrying them
+        std::uint32_t flags = events[i].events;
+        bool failed = flags & (EPOLLERR | EPOLLHUP);
+        retryEpollOperations(events[i].data.fd, failed || (flags & EPOLLIN), failed || (flags & EPOLLOUT), failed);
+    }
+
+    return !queued.empty() || numEvents > 0;
+}
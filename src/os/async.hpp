@@ -3,9 +3,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <cassert>
 #include <coroutine>
+#include <cstdint>
+#include <exception>
 #include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -18,6 +27,9 @@
 #include <sys/event.h>
 #include <unistd.h>
 #elif OS_LINUX
+#include <deque>
+#include <unordered_map>
+
 #include <liburing.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -26,9 +38,62 @@
 #include "error.hpp"
 #include "net/enums.hpp"
 #include "sockets/delegates/traits.hpp"
+#include "utils/cancellation.hpp"
 #include "utils/task.hpp"
 
 namespace Async {
+    // Mechanisms that event loops can be built on.
+    // Linux can use either io_uring or epoll; other platforms only have one backend.
+    enum class Backend {
+        Auto, // Use the fastest backend available (io_uring on Linux, with epoll as a fallback)
+        IOCP, // I/O completion ports (Windows)
+        Kqueue, // kqueue (macOS)
+        IOUring, // io_uring (Linux)
+        Epoll // epoll (Linux)
+    };
+
+    // Gets the display name of a backend.
+    inline const char* getBackendName(Backend backend) {
+        using enum Backend;
+        switch (backend) {
+            case Auto:
+                return "auto";
+            case IOCP:
+                return "IOCP";
+            case Kqueue:
+                return "kqueue";
+            case IOUring:
+                return "io_uring";
+            case Epoll:
+                return "epoll";
+            default:
+                return "Unknown backend";
+        }
+    }
+
+    // Ways to open a file.
+    enum class FileMode {
+        Read, // Open an existing file for reading
+        Write, // Create a file, or truncate an existing file, for writing
+        Append // Create a file, or open an existing file, for writing at its end
+    };
+
+    // An optional feature of an event loop backend that is detected at runtime.
+    struct Capability {
+        const char* name;
+        bool supported; // If the system supports the feature
+        bool used; // If event loops are using the feature
+    };
+
+    // Sizes and overflow counts of io_uring event loop rings, across all threads.
+    struct RingStats {
+        unsigned int sqEntries = 0; // Submission queue entries in each ring
+        unsigned int cqEntries = 0; // Completion queue entries in the largest ring
+        std::uint64_t overflows = 0; // Loop iterations that found a completion queue full
+        std::uint64_t dropped = 0; // Completions lost on kernels that cannot keep completions that do not fit
+        std::uint64_t resizes = 0; // Times a completion queue was grown because it kept overflowing
+    };
+
     // The information needed to resume a completion operation.
     //
     // This structure contains functions to make it an awaitable type. Calling co_await on an instance stores the
@@ -41,8 +106,11 @@ namespace Async {
 #endif
     {
         std::coroutine_handle<> coroHandle; // The handle to the coroutine that started the operation
+        Traits::SocketHandleType<SocketTag::IP> handle{}; // The socket or file of the operation, set when submitted
         System::ErrorCode error = 0; // The return code of the asynchronous function (returned to caller)
         int res = 0; // The result the operation (returned to caller, exact meaning depends on operation)
+        std::thread::id owner; // The thread whose event loop handles the operation, set when submitted
+        bool cancelable = false; // If a token can cancel the operation, which keeps it on the awaiting thread's loop
 
 #if OS_WINDOWS
         std::size_t thread = 0;
@@ -72,6 +140,15 @@ namespace Async {
         void await_resume() const noexcept {}
     };
 
+    // The state of a multishot poll, which can complete once for every event until it is canceled.
+    // Events that occur while no coroutine is waiting are combined and returned by the next wait.
+    struct PollResult : CompletionResult {
+        int events = 0; // Events that have not been returned yet
+        bool armed = false; // If a poll has been submitted and can still complete
+        bool waiting = false; // If a coroutine is suspended until the next event
+        bool orphaned = false; // If the owner was destroyed while armed, the event loop frees the state when it ends
+    };
+
     struct OperationBase {
         Traits::SocketHandleType<SocketTag::IP> handle;
         CompletionResult* result;
@@ -130,10 +207,80 @@ namespace Async {
 
     struct Cancel : OperationBase {};
 
-    using Operation = std::variant<Connect, Accept, Send, SendTo, Receive, ReceiveFrom, Shutdown, Close, Cancel>;
+    // Waits for a file descriptor (not only a socket) to become ready, without reading or writing anything.
+    // The result is the poll() events that occurred on Linux, and the amount of data or buffer space on macOS.
+    // Not supported on Windows since IOCP cannot wait for readiness.
+    struct Poll : OperationBase {
+        bool write; // If the operation waits for the descriptor to become writable instead of readable
+        bool multishot = false; // If the result is a PollResult that stays armed after the first event (io_uring)
+        bool errors = false; // If the operation only waits for error events, e.g. a socket error queue (Linux only)
+    };
+
+    // Moves data between a socket and a pipe without copying it through user space (Linux only).
+    // The result is the number of bytes moved, 0 if the socket was closed.
+    struct Splice : OperationBase {
+#if OS_LINUX
+        int pipe; // The pipe end that data is moved into or out of
+        bool toPipe; // If data moves from the socket to the pipe, instead of from the pipe to the socket
+        std::size_t size; // The maximum number of bytes to move
+        std::int64_t offset = -1; // Offset to read a file handle from, or -1 to use its position (or for sockets)
+#endif
+    };
+
+    // File operations use the handle field for the file (a HANDLE on Windows).
+    // They are asynchronous with io_uring, and run synchronously by other backends since readiness-based APIs cannot
+    // wait for disk I/O.
+
+    // Opens a file. The result is the new file descriptor.
+    struct OpenFile : OperationBase {
+        const char* path;
+        FileMode mode;
+#if OS_WINDOWS
+        HANDLE* file; // Receives the new file handle, which does not fit in the result on Windows
+#endif
+    };
+
+    // Reads from a file at an offset, or at the file position if the offset is -1.
+    struct ReadFile : OperationBase {
+        std::string& data;
+        std::int64_t offset;
+    };
+
+    // Writes to a file at an offset, or at the file position if the offset is -1.
+    struct WriteFile : OperationBase {
+        std::string_view data;
+        std::int64_t offset;
+    };
+
+    // Flushes a file's data to disk.
+    struct SyncFile : OperationBase {};
+
+    // Closes a file.
+    struct CloseFile : OperationBase {};
+
+    // Cancels one pending operation on the handle, identified by its result, without affecting other operations on
+    // the same handle. The result of the canceled operation is ECANCELED if it had not completed yet.
+    // The target is only compared with pending operations, it is never accessed, so it may be destroyed before the
+    // cancellation runs.
+    struct CancelOperation : OperationBase {
+        CompletionResult* target;
+    };
+
+    using Operation = std::variant<Connect, Accept, Send, SendTo, Receive, ReceiveFrom, Shutdown, Close, Cancel, Poll,
+        Splice, OpenFile, ReadFile, WriteFile, SyncFile, CloseFile, CancelOperation>;
 
 #if OS_MACOS
     using PendingEventsMap = std::unordered_map<std::uint64_t, Async::CompletionResult*>;
+#elif OS_LINUX
+    // Operations on a socket that are waiting for it to become ready (epoll backend).
+    struct EpollPending {
+        std::deque<Operation> reads;
+        std::deque<Operation> writes;
+        std::deque<Operation> errors; // Polls that only wait for error events
+        bool registered = false; // If the socket has been added to the epoll instance
+    };
+
+    using EpollPendingMap = std::unordered_map<int, EpollPending>;
 #endif
 
     class EventLoop {
@@ -143,14 +290,72 @@ namespace Async {
         int kq = -1;
         PendingEventsMap pendingEvents;
 #elif OS_LINUX
-        io_uring ring;
+        Backend backend;
+        unsigned int busyPoll; // Microseconds to poll for completions before sleeping (0 to disable)
+        bool napiBusyPoll = false; // If the kernel busy polls the network devices of sockets while waiting
+        io_uring ring; // Used by the io_uring backend
+        int epfd = -1; // Used by the epoll backend
+        EpollPendingMap epollPending;
+        unsigned int droppedSeen = 0; // Dropped completion count from the ring when it was last checked
+        unsigned int overflowStreak = 0; // Consecutive loop iterations that found the completion queue full
+        int wakeFd = -1; // eventfd written by wake(), polled by the ring or epoll instance
+
+        // Waits for the wakeup eventfd in the ring. Its completions use the descriptor's address as their user data.
+        void armWake();
+
+        // Clears a wakeup after the eventfd became readable.
+        void clearWake();
+
+        // Runs one iteration of the io_uring backend. Returns if any completions were handled.
+        bool runOnceIOUring(bool wait);
+
+        // Handles a completion of a poll submitted by a Poller. Returns its result if a coroutine should be resumed.
+        CompletionResult* completePoll(void* userData, const io_uring_cqe& cqe);
+
+        // Updates overflow statistics, and grows the completion queue if it keeps overflowing.
+        void checkOverflow();
+
+        // Runs one iteration of the epoll backend. Returns if any operations were started or became ready.
+        bool runOnceEpoll(bool wait);
+
+        // Starts an operation, or waits for its socket to become ready if it cannot be completed immediately.
+        // Returns if the operation completed immediately and its coroutine was resumed.
+        bool handleEpollOperation(const Operation& operation);
+
+        // Retries operations waiting for a socket that has become ready.
+        void retryEpollOperations(int fd, bool read, bool write, bool error);
+
+        // Cancels all operations waiting for a socket.
+        void cancelEpollOperations(int fd);
+
+        // Cancels one operation waiting for a socket, if it has not completed yet.
+        void cancelEpollOperation(int fd, CompletionResult* target);
+
+        // Updates the events that epoll waits for on a socket.
+        void updateEpollInterest(int fd);
 #endif
 
         std::vector<Operation> operations;
         std::size_t numOperations = 0; // Events that are being waited on (not events in the queue)
 
+        // Operations submitted from threads that do not run this event loop, moved into the queue by runOnce
+        std::vector<Operation> inbox;
+        std::mutex inboxMutex;
+        std::atomic_bool hasInbox = false;
+        std::atomic_bool wakePending = false; // If a wakeup was signaled and this loop has not handled it yet
+
+        // Moves operations from other threads into the queue.
+        void takeInbox();
+
+        // Interrupts a wait for events in the OS.
+        void signalWake();
+
     public:
-        EventLoop(unsigned int numThreads, unsigned int queueEntries);
+        // The backend is only used on Linux, where Auto tries io_uring and falls back to epoll if it is unavailable.
+        // busyPoll is the time in microseconds to poll for completions before sleeping in each iteration, which also
+        // enables NAPI busy polling in the kernel where it is supported (Linux only).
+        EventLoop(unsigned int numThreads, unsigned int queueEntries, Backend backend = Backend::Auto,
+            unsigned int busyPoll = 0);
 
         ~EventLoop();
 
@@ -162,45 +367,322 @@ namespace Async {
             return numOperations;
         }
 
-        void push(const Operation& operation) {
-            operations.push_back(operation);
+        // Returns the backend used by this event loop.
+        Backend getBackend() const {
+#if OS_WINDOWS
+            return Backend::IOCP;
+#elif OS_MACOS
+            return Backend::Kqueue;
+#elif OS_LINUX
+            return backend;
+#endif
         }
-    };
 
-    // Awaits an asynchronous operation and returns the result.
-    Task<CompletionResult> run(auto fn, System::ErrorType type = System::ErrorType::System) {
-        CompletionResult result;
-        co_await result;
+        // Returns the optional features of this event loop's platform and whether they are being used.
+        std::vector<Capability> getCapabilities() const;
 
-        fn(result);
+        // Adds an operation to the queue. This must be called on the thread that runs this event loop.
+        void push(const Operation& operation) {
+            operations.push_back(operation);
+        }
 
-        co_await std::suspend_always{};
-        result.checkError(type);
+        // Adds an operation from another thread, then wakes this event loop to submit it.
+        void pushRemote(const Operation& operation);
 
-        co_return result;
-    }
+        // Wakes this event loop if it is waiting for events, so it handles work queued by other threads. Wakeups are
+        // coalesced until the loop handles them. This can be called from any thread.
+        // IOCP is shared by all threads on Windows and waits with a short timeout, so this does nothing there.
+        void wake();
+    };
 
     // Initializes the OS async APIs.
+    // queueEntries is the size of the io_uring submission queue for each thread, or 0 to size it from the limit on open
+    // files.
+    // busyPoll is the time in microseconds that event loops poll for completions before sleeping, or 0 to always sleep
+    // (Linux only, see EventLoop).
     // Returns the total number of threads created, including the main thread.
-    unsigned int init(unsigned int numThreads, unsigned int queueEntries);
+    unsigned int init(unsigned int numThreads, unsigned int queueEntries, Backend backend = Backend::Auto,
+        unsigned int busyPoll = 0);
+
+    // Gets the backend that was chosen in init().
+    Backend getBackend();
+
+    // Gets the optional features that were detected in init().
+    std::vector<Capability> getCapabilities();
+
+    // Gets the sizes and overflow counts of io_uring rings (only available on Linux).
+    RingStats getRingStats();
 
     // Explicit cleanup is needed for guaranteed object destruction order.
     void cleanup();
 
-    // Submits an I/O operation to the async event loop.
+    // Handle to the event loop of a thread, which coroutines can be moved to with resumeOn.
+    // I/O operations are handled by the event loop of the thread they are started on, so the I/O of a coroutine running
+    // on an executor (e.g. all reads and writes of a socket that it owns) stays on that executor's loop.
+    class Executor {
+        std::thread::id id; // The thread that runs the event loop
+
+    public:
+        explicit Executor(std::thread::id id) : id(id) {}
+
+        std::thread::id getThreadID() const {
+            return id;
+        }
+
+        // Checks if the calling thread runs this executor's event loop.
+        bool isCurrent() const {
+            return id == std::this_thread::get_id();
+        }
+
+        bool operator==(const Executor&) const = default;
+    };
+
+    // Submits an I/O operation to the event loop of the calling thread.
+    // Threads without an event loop (e.g. offload threads or library callback threads) submit to the main thread's
+    // loop instead, so the operation completes and resumes its coroutine in handleEvents.
     void submit(const Operation& op);
 
-    // Submits work to a worker thread.
-    Task<> queueToThread();
+    // Submits an I/O operation to the event loop of an executor. This can be called from any thread; operations from
+    // other threads are handed over through the loop's inbox, and the loop is woken to submit them.
+    // The operation completes on the executor's thread, which resumes the coroutine waiting on its result there.
+    // Operations that can be canceled by a token must be handled by the calling thread's loop, since cancellation is
+    // not synchronized across threads. Throws std::invalid_argument if one is submitted to another loop.
+    void submit(Executor executor, const Operation& op);
+
+    // Gets the executor of the main thread, whose event loop runs in handleEvents.
+    Executor getMainExecutor();
+
+    // Gets the executors of the worker threads. The order is the same for every call until cleanup().
+    std::vector<Executor> getWorkerExecutors();
+
+    // Gets the executor of the calling thread. Coroutines resumed on a thread without an event loop run on the main
+    // thread instead.
+    inline Executor getCurrentExecutor() {
+        return Executor{ std::this_thread::get_id() };
+    }
+
+    // Resumes a coroutine on the event loop of a thread. This can be called from any thread.
+    // Coroutines posted to the main thread, or to a thread without an event loop, run in handleEvents.
+    void post(std::thread::id id, std::coroutine_handle<> handle);
+
+    // Awaitable that resumes the awaiting coroutine on an executor.
+    // The coroutine is queued after it has suspended, so the executor cannot resume it before that. Awaiting the
+    // current executor yields to the other work on its event loop.
+    class [[nodiscard]] ResumeOn {
+        Executor executor;
+
+    public:
+        explicit ResumeOn(Executor executor) : executor(executor) {}
+
+        [[nodiscard]] bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine) const {
+            post(executor.getThreadID(), coroutine);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // Moves the awaiting coroutine to an executor.
+    inline ResumeOn resumeOn(Executor executor) {
+        return ResumeOn{ executor };
+    }
+
+    // Moves the awaiting coroutine to the worker thread with the least queued work, or the main thread if there are no
+    // worker threads.
+    ResumeOn queueToThread();
 
     // Extended queueToThread that can be used to queue to a specific thread.
     // If id == std::thread::id{} then the function is queued to all threads.
     // If the function returns true, it is re-queued onto the thread.
     void queueToThreadEx(std::thread::id id, std::function<Task<bool>()> f);
 
+    // Runs a task on an executor, then resumes the awaiting coroutine on the executor it was on.
+    // The task starts on the executor, so the operations it awaits are handled by that executor's event loop. This
+    // pins a socket's I/O to an executor when the socket is only used by tasks run there.
+    template <class T>
+    LazyTask<T> runOn(Executor executor, LazyTask<T> task) {
+        // Cancellation is not synchronized across threads, so tokens from the caller do not reach the task
+        CancelToken noToken;
+        co_await CancelBoundary{ noToken };
+
+        Executor caller = getCurrentExecutor();
+        co_await resumeOn(executor);
+
+        // Exceptions are held until the coroutine is back on its own executor
+        std::exception_ptr exception;
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await task;
+            } else {
+                T value = co_await task;
+                co_await resumeOn(caller);
+                co_return value;
+            }
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        co_await resumeOn(caller);
+        if constexpr (std::is_void_v<T>) {
+            if (exception) std::rethrow_exception(exception);
+        } else {
+            // Values are returned from the try block, so only failures get here
+            std::rethrow_exception(exception);
+        }
+    }
+
     // Runs one iteration of the main thread's event loop with an optional timeout.
     void handleEvents(bool wait = true);
 
+    // Awaitable that starts an asynchronous operation and returns its result.
+    // The result is stored in the awaiting coroutine's frame, so no other coroutine is created for the operation.
+    // When it is awaited in a task run with withCancellation, canceling the token cancels only this operation, then
+    // the stopped tasks are destroyed once the operation has ended (see withCancellation).
+    // Cancellation is not synchronized across threads, so the token must be canceled on the thread that awaits the
+    // operation, whose event loop handles it.
+    // Fn: a function that submits the operation, given the result to fill in when it completes
+    // Throws: if errors are thrown, instead of returned in a System::Expected
+    template <class Fn, bool Throws = true>
+    class [[nodiscard]] OperationAwaiter final : CancelCallback {
+        Fn fn;
+        System::ErrorType type;
+        CompletionResult result;
+        TaskPromiseBase* promise = nullptr; // The awaiting task, if it can be canceled
+        Executor executor = getCurrentExecutor(); // The executor of the awaiting thread
+
+        void onCancel() override {
+            // The completion handle is read by the event loop that owns the operation, so it is only changed there
+            assert(executor.isCurrent() && "Operations must be canceled on the thread that awaits them");
+
+            // An operation handed to another loop before a token reached it cannot be canceled from here, so it runs
+            // to completion
+            if (result.owner != executor.getThreadID()) return;
+
+            submit(executor, CancelOperation{ { result.handle, nullptr }, &result });
+
+            // When the operation ends, control goes to withCancellation instead of the awaiting coroutine
+            result.coroHandle = promise->stop();
+        }
+
+    public:
+        OperationAwaiter(Fn fn, System::ErrorType type) : fn(std::move(fn)), type(type) {}
+
+        // Operations always complete through the event loop.
+        [[nodiscard]] bool await_ready() const noexcept {
+            return false;
+        }
+
+        // Submits the operation. The event loop resumes the awaiting coroutine when it completes.
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coroutine) {
+            if constexpr (std::is_base_of_v<TaskPromiseBase, Promise>) {
+                promise = &coroutine.promise();
+
+                // Nothing is submitted if the task was canceled before it got here
+                if (promise->cancelToken.isCanceled()) return promise->stop();
+            }
+
+            // The frame is not touched after submitting, since an operation submitted to another thread's event loop
+            // can complete and resume the coroutine before this returns
+            if (promise) {
+                promise->pendingOperation = this;
+                attach(promise->cancelToken);
+            }
+
+            result.coroHandle = coroutine;
+            result.cancelable = promise && promise->cancelToken;
+
+            try {
+                fn(result);
+            } catch (...) {
+                // Nothing was submitted, so the awaiter is not pending
+                if (promise) promise->pendingOperation = nullptr;
+                detach();
+                throw;
+            }
+
+            return std::noop_coroutine();
+        }
+
+        // Throws or returns the error if the operation failed, otherwise returns its result.
+        auto await_resume() {
+            if (promise) promise->pendingOperation = nullptr;
+            detach();
+
+            if constexpr (Throws) {
+                result.checkError(type);
+                return result;
+            } else {
+                using Expected = System::Expected<CompletionResult>;
+                if (System::isFatal(result.error)) return Expected{ std::unexpect, result.error, type };
+                return Expected{ result };
+            }
+        }
+    };
+
+    // Awaits an asynchronous operation and returns the result.
+    template <class Fn>
+    OperationAwaiter<Fn> run(Fn fn, System::ErrorType type = System::ErrorType::System) {
+        return { std::move(fn), type };
+    }
+
+    // Awaits an asynchronous operation and returns the result, or the error if it failed, without throwing.
+    template <class Fn>
+    OperationAwaiter<Fn, false> tryRun(Fn fn, System::ErrorType type = System::ErrorType::System) {
+        return { std::move(fn), type };
+    }
+
+#if !OS_WINDOWS
+    // Waits until a file descriptor can be read without blocking.
+    inline auto readable(int fd) {
+        return run([fd](CompletionResult& result) { submit(Poll{ { fd, &result }, false }); });
+    }
+
+    // Waits until a file descriptor can be written without blocking.
+    inline auto writable(int fd) {
+        return run([fd](CompletionResult& result) { submit(Poll{ { fd, &result }, true }); });
+    }
+
+#if OS_LINUX
+    // Waits until a file descriptor reports an error event (e.g. a message in a socket's error queue) or a hangup.
+    inline auto errored(int fd) {
+        return run([fd](CompletionResult& result) { submit(Poll{ { fd, &result }, false, false, true }); });
+    }
+#endif
+
+    // Waits repeatedly for a file descriptor to become ready (e.g. an eventfd, timerfd, or pipe).
+    // With io_uring, one multishot poll stays armed between waits, so it is not resubmitted for every event. Other
+    // backends submit a poll for each wait.
+    class Poller {
+        int fd;
+        bool write;
+        PollResult* state = new PollResult;
+
+    public:
+        explicit Poller(int fd, bool write = false) : fd(fd), write(write) {}
+
+        Poller(const Poller&) = delete;
+
+        Poller& operator=(const Poller&) = delete;
+
+        // Cancels the poll. The cancellation runs in the next event loop iteration, and the descriptor must stay open
+        // until then.
+        ~Poller();
+
+        // Waits for the next events and returns them (see Poll).
+        // Events from a multishot poll that occurred since the last wait are combined and returned immediately.
+        Task<int> next();
+
+        // Cancels all pending operations on the descriptor, including waits for this poller.
+        void cancel() {
+            submit(Cancel{ { fd, nullptr } });
+        }
+    };
+#endif
+
 #if OS_WINDOWS
     // Adds a socket to IOCP.
     void add(SOCKET s);
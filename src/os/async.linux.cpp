@@ -3,19 +3,229 @@
 
 #include "async.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <variant>
+#include <vector>
 
+#include <fcntl.h>
 #include <liburing.h>
 #include <linux/time_types.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include "errcheck.hpp"
+#include "fileops.hpp"
 #include "utils/overload.hpp"
 
-void handleOperation(io_uring& ring, const Async::Operation& next) {
+// Limits of the number of submission queue entries chosen if 0 is passed to the event loop
+constexpr unsigned int minDefaultQueueEntries = 64;
+constexpr unsigned int maxDefaultQueueEntries = 4096;
+
+// Minimum number of submission queue entries, so linked operations fit in one submission
+constexpr unsigned int minQueueEntries = 2;
+
+// Completion queues are larger than submission queues since operations (e.g. receives on idle sockets) can be waited
+// on for much longer than it takes to submit them
+constexpr unsigned int completionQueueFactor = 4;
+
+// Number of consecutive loop iterations that find the completion queue overflowing before the ring is grown
+constexpr unsigned int overflowGrowThreshold = 8;
+
+// Maximum number of completions to process in one loop iteration
+constexpr unsigned int maxCompletions = 64;
+
+// Set in the user data of multishot polls, which point to a PollResult instead of a CompletionResult
+constexpr std::uintptr_t multishotTag = 1;
+
+// Statistics across all rings
+std::atomic_uint sqEntries = 0;
+std::atomic_uint cqEntries = 0;
+std::atomic_uint64_t numOverflows = 0;
+std::atomic_uint64_t numDropped = 0;
+std::atomic_uint64_t numResizes = 0;
+
+// Resizes the rings of an io_uring instance (kernel 6.13), returning 0 on success or a negative error code.
+// The function was added in liburing 2.9, so resizing is reported as unsupported when building with older versions.
+int resizeRings([[maybe_unused]] io_uring& ring, [[maybe_unused]] io_uring_params& params) {
+#if IO_URING_CHECK_VERSION(2, 9) // True if liburing is older than 2.9
+    return -EOPNOTSUPP;
+#else
+    return io_uring_resize_rings(&ring, &params);
+#endif
+}
+
+// Raises a value to at least another value.
+void updateMax(std::atomic_uint& value, unsigned int other) {
+    unsigned int current = value.load(std::memory_order_relaxed);
+    while (current < other && !value.compare_exchange_weak(current, other, std::memory_order_relaxed)) {}
+}
+
+// Gets the number of submission queue entries to use if 0 is passed to the event loop.
+// Each open socket usually has an operation pending (e.g. a receive), so the completion queue is sized to hold one
+// completion for every file the process can open. Rings whose completion queue still overflows are grown (see
+// EventLoop::checkOverflow()).
+unsigned int getDefaultQueueEntries() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == -1) return minDefaultQueueEntries;
+
+    rlim_t files = std::min<rlim_t>(limit.rlim_cur, maxDefaultQueueEntries * completionQueueFactor);
+    unsigned int entries = std::bit_ceil(static_cast<unsigned int>(files) / completionQueueFactor);
+    return std::clamp(entries, minDefaultQueueEntries, maxDefaultQueueEntries);
+}
+
+// io_uring features of the running kernel.
+struct IOUringSupport {
+    int error = 0; // Error from creating a ring, 0 if io_uring is available
+    unsigned int flags = 0; // Setup flags that rings are created with
+    unsigned int features = 0; // IORING_FEAT_* flags reported by the kernel
+    bool shutdown = false; // If IORING_OP_SHUTDOWN is supported
+    bool close = false; // If IORING_OP_CLOSE is supported
+    bool files = false; // If IORING_OP_OPENAT, IORING_OP_READ, and IORING_OP_WRITE are supported
+    bool splice = false; // If IORING_OP_SPLICE is supported
+    bool sendZC = false; // If IORING_OP_SEND_ZC is supported
+    bool msgRing = false; // If IORING_OP_MSG_RING is supported
+    bool resize = false; // If rings can be resized
+    bool multishotPoll = false; // If polls can stay armed after their first event
+    bool napi = false; // If NAPI busy polling can be registered with a ring
+
+    bool hasFlag(unsigned int flag) const {
+        return (flags & flag) != 0;
+    }
+
+    bool hasFeature(unsigned int feature) const {
+        return (features & feature) != 0;
+    }
+
+    // Checks if operations without completion results can skip their completions when they succeed.
+    bool skipSuccess() const {
+        return hasFeature(IORING_FEAT_CQE_SKIP);
+    }
+};
+
+// Detects io_uring features by creating a ring with the fastest setup flags that the kernel accepts.
+IOUringSupport probeSupport() {
+    // Flags from newest to oldest kernel (DEFER_TASKRUN needs 6.1, SINGLE_ISSUER needs 6.0, COOP_TASKRUN needs 5.19,
+    // CLAMP needs 5.6)
+    constexpr unsigned int sized = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    constexpr std::array flagSets{
+        IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN | sized,
+        IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN | sized,
+        IORING_SETUP_COOP_TASKRUN | sized,
+        sized,
+        0U,
+    };
+
+    IOUringSupport support;
+    io_uring ring;
+
+    for (auto flags : flagSets) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        params.flags = flags;
+        params.cq_entries = 4;
+
+        // Unsupported flags are rejected with EINVAL, other errors mean io_uring is unavailable
+        support.error = -io_uring_queue_init_params(2, &ring, &params);
+        if (support.error == EINVAL) continue;
+        if (support.error != 0) return support;
+
+        support.flags = flags;
+        support.features = params.features;
+        break;
+    }
+
+    if (support.error != 0) return support;
+
+    // Opcodes can only be probed on kernel 5.6 and later, which is also when the oldest probed opcode was added
+    if (io_uring_probe* probe = io_uring_get_probe_ring(&ring)) {
+        support.shutdown = io_uring_opcode_supported(probe, IORING_OP_SHUTDOWN);
+        support.close = io_uring_opcode_supported(probe, IORING_OP_CLOSE);
+        support.files = io_uring_opcode_supported(probe, IORING_OP_OPENAT)
+            && io_uring_opcode_supported(probe, IORING_OP_READ) && io_uring_opcode_supported(probe, IORING_OP_WRITE);
+        support.splice = io_uring_opcode_supported(probe, IORING_OP_SPLICE);
+        support.sendZC = io_uring_opcode_supported(probe, IORING_OP_SEND_ZC);
+        support.msgRing = io_uring_opcode_supported(probe, IORING_OP_MSG_RING);
+        io_uring_free_probe(probe);
+    }
+
+    // Multishot polls cannot be probed, they were added in kernel 5.13 along with IORING_FEAT_RSRC_TAGS
+    support.multishotPoll = support.hasFeature(IORING_FEAT_RSRC_TAGS);
+
+    // NAPI busy polling (kernel 6.9) is checked by registering it, the ring is destroyed afterwards anyway
+    io_uring_napi napi;
+    std::memset(&napi, 0, sizeof(napi));
+    support.napi = io_uring_register_napi(&ring, &napi) == 0;
+
+    // Resizing (kernel 6.13) is only possible with DEFER_TASKRUN, it is checked by resizing to the same size
+    if (support.hasFlag(IORING_SETUP_DEFER_TASKRUN)) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        params.flags = sized;
+        params.sq_entries = ring.sq.ring_entries;
+        params.cq_entries = ring.cq.ring_entries;
+        support.resize = resizeRings(ring, params) == 0;
+    }
+
+    io_uring_queue_exit(&ring);
+    return support;
+}
+
+// Gets the io_uring features, which are detected when the main event loop is created in Async::init().
+const IOUringSupport& getSupport() {
+    static const IOUringSupport support = probeSupport();
+    return support;
+}
+
+// Prepares an operation for io_uring, or completes it immediately if the kernel cannot run it asynchronously.
+// Results of operations that completed immediately are added to a list to be resumed by the caller.
+// Returns if a completion will be posted for the operation.
+bool handleOperation(io_uring& ring, const Async::Operation& next, std::vector<Async::CompletionResult*>& completed) {
+    const auto& support = getSupport();
+    auto result = std::visit([](const Async::OperationBase& op) { return op.result; }, next);
+
+    bool closeFile = std::holds_alternative<Async::CloseFile>(next);
+    if ((!support.files || (closeFile && !support.close)) && runFileOperation(next)) {
+        if (result) completed.push_back(result);
+        return false;
+    }
+
+    // Splices cannot be emulated without waiting, callers can fall back to copying the data
+    if (std::holds_alternative<Async::Splice>(next) && !support.splice) {
+        result->error = EOPNOTSUPP;
+        completed.push_back(result);
+        return false;
+    }
+
+    if (auto op = std::get_if<Async::Shutdown>(&next); op && !support.shutdown) {
+        shutdown(op->handle, SHUT_RDWR);
+        return false;
+    }
+
+    if (auto op = std::get_if<Async::Close>(&next); op && !support.close) {
+        close(op->handle);
+        return false;
+    }
+
     io_uring_sqe* sqe = io_uring_get_sqe(&ring);
 
+    // Operations without completion results are only waited on if they fail
+    auto skipSuccess = [=](unsigned int flags = 0) {
+        io_uring_sqe_set_data(sqe, nullptr);
+        io_uring_sqe_set_flags(sqe, flags | (support.skipSuccess() ? IOSQE_CQE_SKIP_SUCCESS : 0));
+    };
+
     Overload visitor{
         [=](const Async::Connect& op) {
             io_uring_prep_connect(sqe, op.handle, op.addr, op.addrLen);
@@ -42,64 +252,385 @@ void handleOperation(io_uring& ring, const Async::Operation& next) {
             io_uring_sqe_set_data(sqe, op.result);
         },
         [=](const Async::Shutdown& op) {
+            // Shutdowns are always followed by a close (see SocketHandle::closeImpl()), they are linked so the socket
+            // is not closed and its number reused before the shutdown runs
             io_uring_prep_shutdown(sqe, op.handle, SHUT_RDWR);
-            io_uring_sqe_set_data(sqe, nullptr);
+            skipSuccess(IOSQE_IO_HARDLINK);
         },
         [=](const Async::Close& op) {
             io_uring_prep_close(sqe, op.handle);
-            io_uring_sqe_set_data(sqe, nullptr);
+            skipSuccess();
         },
         [=](const Async::Cancel& op) {
             io_uring_prep_cancel_fd(sqe, op.handle, IORING_ASYNC_CANCEL_ALL);
-            io_uring_sqe_set_data(sqe, nullptr);
+            skipSuccess();
+        },
+        [=](const Async::CancelOperation& op) {
+            // Operations are identified by their user data, which is their result
+            io_uring_prep_cancel(sqe, op.target, 0);
+            skipSuccess();
+        },
+        [=](const Async::Splice& op) {
+            int in = op.toPipe ? op.handle : op.pipe;
+            int out = op.toPipe ? op.pipe : op.handle;
+            std::int64_t inOffset = op.toPipe ? op.offset : -1;
+            io_uring_prep_splice(sqe, in, inOffset, out, -1, static_cast<unsigned int>(op.size), SPLICE_F_MOVE);
+            io_uring_sqe_set_data(sqe, op.result);
+        },
+        [=](const Async::OpenFile& op) {
+            io_uring_prep_openat(sqe, AT_FDCWD, op.path, getOpenFlags(op.mode), newFileMode);
+            io_uring_sqe_set_data(sqe, op.result);
+        },
+        [=](const Async::ReadFile& op) {
+            // An offset of -1 (all bits set) makes io_uring use the file position
+            io_uring_prep_read(sqe, op.handle, op.data.data(), op.data.size(), op.offset);
+            io_uring_sqe_set_data(sqe, op.result);
+        },
+        [=](const Async::WriteFile& op) {
+            io_uring_prep_write(sqe, op.handle, op.data.data(), op.data.size(), op.offset);
+            io_uring_sqe_set_data(sqe, op.result);
+        },
+        [=](const Async::SyncFile& op) {
+            io_uring_prep_fsync(sqe, op.handle, 0);
+            io_uring_sqe_set_data(sqe, op.result);
+        },
+        [=](const Async::CloseFile& op) {
+            io_uring_prep_close(sqe, op.handle);
+            if (op.result) io_uring_sqe_set_data(sqe, op.result);
+            else skipSuccess();
+        },
+        [=](const Async::Poll& op) {
+            unsigned int events = op.errors ? POLLERR : op.write ? POLLOUT : POLLIN;
+            if (!op.multishot) {
+                io_uring_prep_poll_add(sqe, op.handle, events);
+                io_uring_sqe_set_data(sqe, op.result);
+                return;
+            }
+
+            // Without kernel support, a single-shot poll is used and rearmed by the next wait
+            if (support.multishotPoll) io_uring_prep_poll_multishot(sqe, op.handle, events);
+            else io_uring_prep_poll_add(sqe, op.handle, events);
+            io_uring_sqe_set_data64(sqe, reinterpret_cast<std::uintptr_t>(op.result) | multishotTag);
         },
     };
 
     std::visit(visitor, next);
+    return result != nullptr || !support.skipSuccess();
 }
 
-Async::EventLoop::EventLoop(unsigned int, unsigned int queueEntries) {
-    io_uring_params params;
-    std::memset(&params, 0, sizeof(params));
-    params.flags = IORING_SETUP_SINGLE_ISSUER;
+Async::EventLoop::EventLoop(unsigned int, unsigned int queueEntries, Backend backend, unsigned int busyPoll) :
+    backend(backend), busyPoll(busyPoll) {
+    const auto& support = getSupport();
+
+    if (backend != Backend::Epoll) {
+        queueEntries = queueEntries == 0 ? getDefaultQueueEntries() : std::max(queueEntries, minQueueEntries);
+
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        params.flags = support.flags;
+        params.cq_entries = queueEntries * completionQueueFactor;
+
+        // io_uring can be unavailable if it is disabled (e.g. by sysctl or seccomp) or if the kernel is too old
+        int ret = support.error == 0 ? io_uring_queue_init_params(queueEntries, &ring, &params) : -support.error;
+        if (ret == 0) {
+            this->backend = Backend::IOUring;
+            sqEntries.store(params.sq_entries, std::memory_order_relaxed);
+            updateMax(cqEntries, params.cq_entries);
+
+            // The kernel busy polls the devices that the ring's sockets receive from while waiting for completions
+            if (busyPoll > 0 && support.napi) {
+                io_uring_napi napi;
+                std::memset(&napi, 0, sizeof(napi));
+                napi.busy_poll_to = busyPoll;
+                napi.prefer_busy_poll = 1;
+                napiBusyPoll = io_uring_register_napi(&ring, &napi) == 0;
+            }
+
+            wakeFd = check(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+            armWake();
+            return;
+        }
 
-    check(io_uring_queue_init_params(queueEntries, &ring, &params), checkZero, useReturnCodeNeg);
+        // Only fall back to epoll if no backend was requested
+        if (backend == Backend::IOUring) check(ret, checkZero, useReturnCodeNeg);
+    }
+
+    this->backend = Backend::Epoll;
+    epfd = check(epoll_create1(EPOLL_CLOEXEC));
+
+#ifdef EPIOCSPARAMS
+    // Busy polling for epoll instances needs kernel 6.9, older kernels reject the request
+    if (busyPoll > 0) {
+        epoll_params epollParams;
+        std::memset(&epollParams, 0, sizeof(epollParams));
+        epollParams.busy_poll_usecs = busyPoll;
+        epollParams.prefer_busy_poll = 1;
+        napiBusyPoll = ioctl(epfd, EPIOCSPARAMS, &epollParams) == 0;
+    }
+#endif
+
+    // The wakeup eventfd is told apart from sockets by its descriptor
+    wakeFd = check(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    epoll_event event{ .events = EPOLLIN, .data = { .fd = wakeFd } };
+    check(epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &event));
 }
 
 Async::EventLoop::~EventLoop() {
-    io_uring_queue_exit(&ring);
+    if (backend == Backend::IOUring) io_uring_queue_exit(&ring);
+    else close(epfd);
+
+    if (wakeFd != -1) close(wakeFd);
+}
+
+void Async::EventLoop::signalWake() {
+    eventfd_write(wakeFd, 1);
+}
+
+void Async::EventLoop::clearWake() {
+    // The descriptor is nonblocking, so this only resets its counter
+    eventfd_t value;
+    eventfd_read(wakeFd, &value);
+    wakePending.store(false);
+}
+
+void Async::EventLoop::armWake() {
+    // The ring is only written from its own thread, so the poll is submitted here and wake() only writes the eventfd
+    io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+    if (!sqe) {
+        io_uring_submit(&ring);
+        sqe = io_uring_get_sqe(&ring);
+    }
+
+    if (getSupport().multishotPoll) io_uring_prep_poll_multishot(sqe, wakeFd, POLLIN);
+    else io_uring_prep_poll_add(sqe, wakeFd, POLLIN);
+    io_uring_sqe_set_data(sqe, &wakeFd);
+    io_uring_submit(&ring);
 }
 
 void Async::EventLoop::runOnce(bool wait) {
+    takeInbox();
+
+    auto runBackend = [this](bool wait) {
+        return backend == Backend::IOUring ? runOnceIOUring(wait) : runOnceEpoll(wait);
+    };
+
+    // Poll for a bounded time before sleeping, so completions that arrive soon are handled without waiting for a
+    // wakeup from the kernel
+    if (wait && busyPoll > 0) {
+        using namespace std::chrono;
+        auto deadline = steady_clock::now() + microseconds{ busyPoll };
+
+        while ((numOperations > 0 || !operations.empty()) && steady_clock::now() < deadline)
+            if (runBackend(false)) return;
+    }
+
+    runBackend(wait);
+}
+
+bool Async::EventLoop::runOnceIOUring(bool wait) {
     __kernel_timespec timeout{ 0, wait ? 200000000 : 0 };
     io_uring_cqe* cqe = nullptr;
+    bool resumed = false; // If operations completed immediately without being submitted
 
     if (operations.empty()) {
-        if (numOperations == 0) return;
+        if (numOperations == 0) return false;
 
-        if (io_uring_wait_cqe_timeout(&ring, &cqe, &timeout) < 0) return;
+        if (io_uring_wait_cqe_timeout(&ring, &cqe, &timeout) < 0) return false;
     } else {
-        // There are queued operations, process them
-        for (const auto& i : operations) handleOperation(ring, i);
-        numOperations += operations.size();
-        operations.clear();
+        // There are queued operations, process as many as the submission queue has space for
+        // The rest are kept for the next iteration, since the kernel can refuse submissions while completions are
+        // overflowing.
+        std::size_t numHandled = 0;
+        std::vector<CompletionResult*> immediate;
+        for (const auto& i : operations) {
+            // Shutdowns are linked to the close after them, so the pair is never split across submissions
+            unsigned int needed = std::holds_alternative<Shutdown>(i) ? 2 : 1;
+            if (io_uring_sq_space_left(&ring) < needed) io_uring_submit(&ring);
+            if (io_uring_sq_space_left(&ring) < needed) break;
+
+            if (handleOperation(ring, i, immediate)) numOperations++;
+            numHandled++;
+        }
+
+        // Operations cannot be assigned (some hold references), so the remaining ones are copied to a new queue
+        std::vector<Operation> remaining(operations.begin() + numHandled, operations.end());
+        std::swap(operations, remaining);
+
+        // Resumed coroutines can submit more operations, which are handled in the next iteration
+        for (auto result : immediate) result->coroHandle();
+        resumed = !immediate.empty();
+
+        // Coroutines that were resumed can have submitted more operations (e.g. a send after a receive) or finished
+        // work that the caller is waiting for, so they are not stalled by a wait
+        if (resumed || !operations.empty()) timeout.tv_nsec = 0;
+
+        // Nothing to wait for if all operations completed immediately or skip their completions
+        // Events are still processed so deferred work (e.g. a close linked to a shutdown) runs without another wait.
+        if (numOperations == 0) {
+            io_uring_submit_and_get_events(&ring);
+            return resumed;
+        }
 
         // Submit to io_uring and wait for next CQE
-        if (io_uring_submit_and_wait_timeout(&ring, &cqe, 1, &timeout, nullptr) < 0) return;
+        if (io_uring_submit_and_wait_timeout(&ring, &cqe, 1, &timeout, nullptr) < 0) return resumed;
+    }
+
+    if (!cqe) return resumed;
+
+    checkOverflow();
+
+    // Process all completions that are ready
+    // Results are resumed after the completion queue is advanced so it is consistent if a coroutine handles events.
+    std::array<io_uring_cqe*, maxCompletions> cqes;
+    unsigned int numCqes = io_uring_peek_batch_cqe(&ring, cqes.data(), maxCompletions);
+
+    std::array<CompletionResult*, maxCompletions> completed;
+    std::size_t numCompleted = 0;
+
+    for (unsigned int i = 0; i < numCqes; i++) {
+        void* userData = io_uring_cqe_get_data(cqes[i]);
+
+        // Wakeups are not counted as operations, their poll is submitted again if it has ended
+        if (userData == &wakeFd) {
+            clearWake();
+            if (!(cqes[i]->flags & IORING_CQE_F_MORE)) armWake();
+            continue;
+        }
+
+        // Completions without results are not counted if they are only posted on failure
+        if (!userData) {
+            if (!getSupport().skipSuccess()) numOperations--;
+            continue;
+        }
+
+        if (reinterpret_cast<std::uintptr_t>(userData) & multishotTag) {
+            if (auto result = completePoll(userData, *cqes[i])) completed[numCompleted++] = result;
+            continue;
+        }
+
+        numOperations--;
+
+        // Fill in completion result information
+        auto& result = *reinterpret_cast<CompletionResult*>(userData);
+        if (cqes[i]->res < 0) result.error = -cqes[i]->res;
+        else result.res = cqes[i]->res;
+
+        completed[numCompleted++] = &result;
+    }
+
+    io_uring_cq_advance(&ring, numCqes);
+    for (std::size_t i = 0; i < numCompleted; i++) completed[i]->coroHandle();
+
+    return resumed || numCompleted > 0;
+}
+
+Async::CompletionResult* Async::EventLoop::completePoll(void* userData, const io_uring_cqe& cqe) {
+    auto& result = *reinterpret_cast<PollResult*>(reinterpret_cast<std::uintptr_t>(userData) & ~multishotTag);
+
+    // The poll is only counted as pending until its last completion
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        numOperations--;
+        result.armed = false;
+    }
+
+    if (cqe.res < 0) result.error = -cqe.res;
+    else result.events |= cqe.res;
+
+    // Orphaned polls wait for their cancellation to end them, then are freed by the coroutine waiting on them if there
+    // is one (see Poller::next())
+    if (result.orphaned) {
+        if (result.armed) return nullptr;
+
+        if (!result.waiting) {
+            delete &result;
+            return nullptr;
+        }
+    }
+
+    // Events that arrive without a waiting coroutine are kept for the next wait
+    if (!result.waiting) return nullptr;
+
+    result.waiting = false;
+    return &result;
+}
+
+void Async::EventLoop::checkOverflow() {
+    // Kernels without IORING_FEAT_NODROP drop completions that do not fit in the queue and count them in the ring
+    // Newer kernels keep the completions and flag the ring until they are moved into the queue.
+    unsigned int dropped = *ring.cq.koverflow;
+    bool overflowing = dropped != droppedSeen || io_uring_cq_has_overflow(&ring);
+
+    numDropped.fetch_add(dropped - droppedSeen, std::memory_order_relaxed);
+    droppedSeen = dropped;
+
+    if (!overflowing) {
+        overflowStreak = 0;
+        return;
+    }
+
+    numOverflows.fetch_add(1, std::memory_order_relaxed);
+    if (++overflowStreak < overflowGrowThreshold || !getSupport().resize) return;
+
+    // Double the completion queue if it keeps overflowing
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.sq_entries = ring.sq.ring_entries;
+    params.cq_entries = ring.cq.ring_entries * 2;
+
+    if (resizeRings(ring, params) == 0) {
+        numResizes.fetch_add(1, std::memory_order_relaxed);
+        updateMax(cqEntries, ring.cq.ring_entries);
     }
 
-    if (!cqe) return;
+    overflowStreak = 0;
+}
 
-    void* userData = io_uring_cqe_get_data(cqe);
-    io_uring_cqe_seen(&ring, cqe);
-    numOperations--;
+std::vector<Async::Capability> Async::EventLoop::getCapabilities() const {
+    const auto& support = getSupport();
+    bool used = backend == Backend::IOUring;
 
-    if (!userData) return;
+    // Fast paths that the kernel uses by itself are in use whenever they are supported
+    auto flag = [&](const char* name, unsigned int flag) {
+        return Capability{ name, support.hasFlag(flag), used && support.hasFlag(flag) };
+    };
+
+    auto feature = [&](const char* name, unsigned int feature) {
+        return Capability{ name, support.hasFeature(feature), used && support.hasFeature(feature) };
+    };
 
-    // Fill in completion result information
-    auto& result = *reinterpret_cast<CompletionResult*>(userData);
-    if (cqe->res < 0) result.error = -cqe->res;
-    else result.res = cqe->res;
+    // COOP_TASKRUN is older than DEFER_TASKRUN but is not used with it
+    bool coopTaskrun = support.hasFlag(IORING_SETUP_COOP_TASKRUN) || support.hasFlag(IORING_SETUP_DEFER_TASKRUN);
 
-    result.coroHandle();
+    return {
+        { "io_uring", support.error == 0, used },
+        flag("Single issuer", IORING_SETUP_SINGLE_ISSUER),
+        flag("Deferred task running", IORING_SETUP_DEFER_TASKRUN),
+        { "Cooperative task running", coopTaskrun, used && support.hasFlag(IORING_SETUP_COOP_TASKRUN) },
+        feature("Fast poll", IORING_FEAT_FAST_POLL),
+        feature("No dropped completions", IORING_FEAT_NODROP),
+        feature("Extended wait arguments", IORING_FEAT_EXT_ARG),
+        feature("Skip successful completions", IORING_FEAT_CQE_SKIP),
+        flag("Completion queue size", IORING_SETUP_CQSIZE),
+        { "Ring resizing", support.resize, used && support.resize },
+        { "Asynchronous shutdown", support.shutdown, used && support.shutdown },
+        { "Asynchronous close", support.close, used && support.close },
+        { "Asynchronous file I/O", support.files, used && support.files },
+        { "Splice", support.splice, used && support.splice },
+        { "Zero-copy send", support.sendZC, false },
+        { "Ring messages", support.msgRing, false },
+        { "Multishot poll", support.multishotPoll, used && support.multishotPoll },
+        { "NAPI busy polling", support.napi, napiBusyPoll },
+        { "epoll", true, backend == Backend::Epoll },
+    };
+}
+
+Async::RingStats Async::getRingStats() {
+    return {
+        sqEntries.load(std::memory_order_relaxed),
+        cqEntries.load(std::memory_order_relaxed),
+        numOverflows.load(std::memory_order_relaxed),
+        numDropped.load(std::memory_order_relaxed),
+        numResizes.load(std::memory_order_relaxed),
+    };
 }
@@ -15,6 +15,7 @@
 #include <unistd.h>
 
 #include "errcheck.hpp"
+#include "fileops.hpp"
 #include "utils/overload.hpp"
 
 std::uint64_t getMapID(int s, std::int16_t filt) {
@@ -30,14 +31,46 @@ std::uint64_t getMapID(int s, std::int16_t filt) {
     return static_cast<std::uint64_t>(s) | filterBit;
 }
 
-Async::EventLoop::EventLoop(unsigned int, unsigned int) : kq(check(kqueue())) {}
+// Identifier of the user event that wakes an event loop.
+constexpr std::uintptr_t wakeIdent = 0;
+
+Async::EventLoop::EventLoop(unsigned int, unsigned int, Backend, unsigned int) : kq(check(kqueue())) {
+    struct kevent event {};
+    EV_SET(&event, wakeIdent, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+    if (kevent(kq, &event, 1, nullptr, 0, nullptr) == -1) {
+        close(kq);
+        throw System::SystemError{ errno, System::ErrorType::System };
+    }
+}
 
 Async::EventLoop::~EventLoop() {
     close(kq);
 }
 
+void Async::EventLoop::signalWake() {
+    struct kevent event {};
+    EV_SET(&event, wakeIdent, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+    kevent(kq, &event, 1, nullptr, 0, nullptr);
+}
+
+std::vector<Async::Capability> Async::EventLoop::getCapabilities() const {
+    // kqueue has no optional features that need to be detected
+    return {};
+}
+
+Async::RingStats Async::getRingStats() {
+    return {};
+}
+
 void handleOperation(Async::PendingEventsMap& pendingEvents, std::vector<struct kevent>& events,
     const Async::Operation& next, std::size_t& numOperations) {
+    // kqueue cannot wait for disk I/O, so file operations are run immediately
+    if (runFileOperation(next)) {
+        auto result = std::visit([](const Async::OperationBase& op) { return op.result; }, next);
+        if (result) result->coroHandle();
+        return;
+    }
+
     auto submit = [&](int id, std::int16_t filt, Async::CompletionResult* result) {
         // Set EV_RECEIPT flag to get error status on kevent
         const std::uint16_t flags = EV_ADD | EV_ONESHOT | EV_RECEIPT;
@@ -53,6 +86,7 @@ void handleOperation(Async::PendingEventsMap& pendingEvents, std::vector<struct
         [&](const Async::SendTo& op) { submit(op.handle, EVFILT_WRITE, op.result); },
         [&](const Async::Receive& op) { submit(op.handle, EVFILT_READ, op.result); },
         [&](const Async::ReceiveFrom& op) { submit(op.handle, EVFILT_READ, op.result); },
+        [&](const Async::Poll& op) { submit(op.handle, op.write ? EVFILT_WRITE : EVFILT_READ, op.result); },
         [&](const Async::Shutdown& op) { shutdown(op.handle, SHUT_RDWR); },
         [&](const Async::Close& op) { close(op.handle); },
         [&](const Async::Cancel& op) {
@@ -70,25 +104,56 @@ void handleOperation(Async::PendingEventsMap& pendingEvents, std::vector<struct
                 result.coroHandle();
             }
         },
+        [&](const Async::CancelOperation& op) {
+            for (std::int16_t filt : { EVFILT_READ, EVFILT_WRITE }) {
+                // The target is only compared since it may have completed and been destroyed
+                auto it = pendingEvents.find(getMapID(op.handle, filt));
+                if (it == pendingEvents.end() || it->second != op.target) continue;
+
+                events.push_back({ static_cast<std::uintptr_t>(op.handle), filt, EV_DELETE, 0, 0, nullptr });
+                numOperations--;
+                pendingEvents.erase(it);
+
+                op.target->error = ECANCELED;
+                op.target->coroHandle();
+                return;
+            }
+        },
+        [&](const Async::Splice& op) {
+            // Splicing is specific to Linux
+            op.result->error = ENOTSUP;
+            op.result->coroHandle();
+        },
+        [](const auto&) {}, // File operations are handled above
     };
 
     std::visit(visitor, next);
 }
 
 void Async::EventLoop::runOnce(bool wait) {
+    takeInbox();
+
     if (operations.empty()) {
         if (numOperations == 0) return;
     } else {
         std::vector<struct kevent> events;
 
-        for (const auto& i : operations) handleOperation(pendingEvents, events, i, numOperations);
-        operations.clear();
+        // Resumed coroutines can submit operations, so the queue is swapped out before it is processed
+        std::vector<Operation> queued;
+        std::swap(queued, operations);
+        for (const auto& i : queued) handleOperation(pendingEvents, events, i, numOperations);
 
         // Submit pending events from queue
         timespec timeout{ 0, 0 };
         if (kevent(kq, events.data(), events.size(), events.data(), events.size(), &timeout) == 0) return;
 
         for (const auto& i : events) {
+            // A wakeup can be returned along with the receipts
+            if (i.filter == EVFILT_USER) {
+                wakePending.store(false);
+                continue;
+            }
+
             // Get events that set error status
             if (!(i.flags & EV_ERROR) || i.data == 0 || !i.udata) continue;
 
@@ -109,6 +174,13 @@ void Async::EventLoop::runOnce(bool wait) {
 
     // Wait for one event from kqueue
     if (kevent(kq, nullptr, 0, &event, 1, &timeout) <= 0) return;
+
+    // Wakeups are not counted as operations, they only end the wait
+    if (event.filter == EVFILT_USER) {
+        wakePending.store(false);
+        return;
+    }
+
     numOperations--;
 
     // Pop an event from the map and get its completion result
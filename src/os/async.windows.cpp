@@ -4,6 +4,7 @@
 #include "async.hpp"
 
 #include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <variant>
 #include <vector>
@@ -49,7 +50,49 @@ void loadAcceptEx(SOCKET s) {
         &numBytes, nullptr, nullptr));
 }
 
-void handleOperation(const Async::Operation& operation, std::size_t thread) {
+// Gets a file handle from an operation, where it is stored as a socket.
+HANDLE getFileHandle(const Async::OperationBase& op) {
+    return reinterpret_cast<HANDLE>(op.handle);
+}
+
+// Gets an OVERLAPPED structure to read or write a file at an offset, or null to use the file position.
+OVERLAPPED* getFileOffset(std::int64_t offset, OVERLAPPED& overlapped) {
+    if (offset < 0) return nullptr;
+
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    return &overlapped;
+}
+
+// Opens a file for synchronous I/O.
+// Files are not added to IOCP since overlapped file I/O can still complete synchronously (e.g. when extending a file).
+HANDLE openFile(const Async::OpenFile& op) {
+    DWORD access = GENERIC_WRITE;
+    DWORD disposition = CREATE_ALWAYS;
+
+    switch (op.mode) {
+        case Async::FileMode::Read:
+            access = GENERIC_READ;
+            disposition = OPEN_EXISTING;
+            break;
+        case Async::FileMode::Append:
+            access = FILE_APPEND_DATA;
+            disposition = OPEN_ALWAYS;
+            break;
+        default:
+            break;
+    }
+
+    return check(CreateFileA(op.path, access, FILE_SHARE_READ, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr),
+        [](HANDLE h) { return h != INVALID_HANDLE_VALUE; });
+}
+
+// Starts an operation. Returns if a completion packet will be posted for it.
+bool handleOperation(const Async::Operation& operation, std::size_t thread) {
+    // File operations run synchronously and store their results here
+    DWORD numBytes = 0;
+    OVERLAPPED offset{};
+
     Overload visitor{
         [=](const Async::Connect& op) {
             check(connectExPtr(op.handle, op.addr, static_cast<int>(op.addrLen), nullptr, 0, nullptr, op.result),
@@ -82,6 +125,31 @@ void handleOperation(const Async::Operation& operation, std::size_t thread) {
         [=](const Async::Shutdown& op) { shutdown(op.handle, SD_BOTH); },
         [=](const Async::Close& op) { closesocket(op.handle); },
         [=](const Async::Cancel& op) { CancelIo(reinterpret_cast<HANDLE>(op.handle)); },
+        [=](const Async::CancelOperation& op) {
+            // The operation completes through IOCP with ERROR_OPERATION_ABORTED if it was still pending
+            CancelIoEx(reinterpret_cast<HANDLE>(op.handle), op.target);
+        },
+        [=](const Async::Poll&) {
+            // IOCP only reports completions, not readiness
+            throw System::SystemError{ WSAEOPNOTSUPP, System::ErrorType::System };
+        },
+        [=](const Async::Splice&) {
+            // Splicing is specific to Linux
+            throw System::SystemError{ WSAEOPNOTSUPP, System::ErrorType::System };
+        },
+        [&](const Async::OpenFile& op) { *op.file = openFile(op); },
+        [&](const Async::ReadFile& op) {
+            auto size = static_cast<DWORD>(op.data.size());
+            check(::ReadFile(getFileHandle(op), op.data.data(), size, &numBytes, getFileOffset(op.offset, offset)),
+                checkTrue);
+        },
+        [&](const Async::WriteFile& op) {
+            auto size = static_cast<DWORD>(op.data.size());
+            check(::WriteFile(getFileHandle(op), op.data.data(), size, &numBytes, getFileOffset(op.offset, offset)),
+                checkTrue);
+        },
+        [=](const Async::SyncFile& op) { check(FlushFileBuffers(getFileHandle(op)), checkTrue); },
+        [=](const Async::CloseFile& op) { check(CloseHandle(getFileHandle(op)), checkTrue); },
     };
 
     std::visit(
@@ -90,18 +158,35 @@ void handleOperation(const Async::Operation& operation, std::size_t thread) {
         },
         operation);
 
+    Async::CompletionResult* result = nullptr;
+    std::visit([&](auto&& op) { result = op.result; }, operation);
+
     try {
         std::visit(visitor, operation);
     } catch (const System::SystemError& e) {
-        Async::CompletionResult* result;
-        std::visit([&](auto&& op) { result = op.result; }, operation);
+        // Files can be closed without waiting for the result
+        if (!result) return false;
 
         result->error = e.code;
         result->coroHandle();
+        return false;
+    }
+
+    // Operations that are not overlapped have already finished
+    using namespace Async;
+    bool overlapped = std::holds_alternative<Connect>(operation) || std::holds_alternative<Accept>(operation)
+        || std::holds_alternative<Send>(operation) || std::holds_alternative<SendTo>(operation)
+        || std::holds_alternative<Receive>(operation) || std::holds_alternative<ReceiveFrom>(operation);
+    if (overlapped) return true;
+
+    if (result) {
+        result->res = static_cast<int>(numBytes);
+        result->coroHandle();
     }
+    return false;
 }
 
-Async::EventLoop::EventLoop(unsigned int numThreads, unsigned int) {
+Async::EventLoop::EventLoop(unsigned int numThreads, unsigned int, Backend, unsigned int) {
     std::scoped_lock lock{ runningMutex };
 
     // Initialization and cleanup happen on the first thread that is initialized
@@ -137,8 +222,25 @@ Async::EventLoop::~EventLoop() {
     }
 }
 
+void Async::EventLoop::signalWake() {
+    // The completion port is shared, so a packet posted to it would wake any thread; each thread instead picks up its
+    // inbox after its short wait times out
+    wakePending.store(false);
+}
+
+std::vector<Async::Capability> Async::EventLoop::getCapabilities() const {
+    // IOCP has no optional features that need to be detected
+    return {};
+}
+
+Async::RingStats Async::getRingStats() {
+    return {};
+}
+
 void Async::EventLoop::runOnce(bool wait) {
-    // Check for submits from other threads
+    takeInbox();
+
+    // Check for completions of operations started by this thread that another thread dequeued
     Resubmit& pendingSubmits = resubmits[thisId];
     bool expected = true;
     if (pendingSubmits.hasHandles.compare_exchange_weak(expected, false, std::memory_order_relaxed)) {
@@ -152,11 +254,11 @@ void Async::EventLoop::runOnce(bool wait) {
         for (auto i : tmp) i();
     }
 
-    if (!operations.empty()) {
-        for (const auto& i : operations) handleOperation(i, thisId);
-        numOperations += operations.size();
-        operations.clear();
-    }
+    // Resumed coroutines can submit operations, so the queue is swapped out before it is processed
+    std::vector<Operation> queued;
+    std::swap(queued, operations);
+    for (const auto& i : queued)
+        if (handleOperation(i, thisId)) numOperations++;
 
     DWORD numBytes;
     ULONG_PTR completionKey;
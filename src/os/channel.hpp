@@ -0,0 +1,223 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "async.hpp"
+
+namespace Async {
+    // Bounded queue of values passed between coroutines, which can run on different event loop threads.
+    // Sending waits while the channel is full, and receiving waits while it is empty. A waiting coroutine is resumed
+    // on the thread it was suspended on through post(), so it does not need to poll or re-queue itself.
+    // Any number of coroutines can send and receive. The channel must outlive all coroutines waiting on it.
+    template <class T>
+    class Channel {
+        // Coroutine waiting to send a value.
+        struct SendWaiter {
+            T* value;
+            std::coroutine_handle<> handle;
+            std::thread::id thread;
+            bool sent = false;
+        };
+
+        // Coroutine waiting to receive a value.
+        struct RecvWaiter {
+            std::optional<T>* value;
+            std::coroutine_handle<> handle;
+            std::thread::id thread;
+        };
+
+        std::mutex mutex;
+        std::size_t capacity;
+        std::deque<T> items;
+        std::deque<SendWaiter*> senders; // Senders waiting for space, in order
+        std::deque<RecvWaiter*> receivers; // Receivers waiting for values, in order
+        bool closed = false;
+
+        // Passes a value to a waiting receiver, or adds it to the queue if there is space.
+        // Returns false if there was no space. If the value went to a receiver, it is set to be resumed.
+        // The mutex must be locked.
+        bool place(T& value, RecvWaiter*& receiver) {
+            if (!receivers.empty()) {
+                receiver = receivers.front();
+                receivers.pop_front();
+                receiver->value->emplace(std::move(value));
+                return true;
+            }
+
+            if (items.size() >= capacity) return false;
+            items.push_back(std::move(value));
+            return true;
+        }
+
+        // Takes the next value, refilling the queue from the first waiting sender, which is set to be resumed.
+        // The mutex must be locked.
+        std::optional<T> take(SendWaiter*& sender) {
+            std::optional<T> value;
+            if (!items.empty()) {
+                value.emplace(std::move(items.front()));
+                items.pop_front();
+            }
+
+            if (!senders.empty()) {
+                sender = senders.front();
+                senders.pop_front();
+                sender->sent = true;
+
+                // With no capacity, values go straight from senders to receivers
+                if (value) items.push_back(std::move(*sender->value));
+                else value.emplace(std::move(*sender->value));
+            }
+
+            return value;
+        }
+
+    public:
+        // Awaitable that sends a value, returning false if the channel was closed.
+        class [[nodiscard]] SendAwaiter {
+            Channel& channel;
+            T value;
+            SendWaiter waiter{ &value };
+
+        public:
+            SendAwaiter(Channel& channel, T value) : channel(channel), value(std::move(value)) {}
+
+            // The channel refers to the value in this object while it waits
+            SendAwaiter(const SendAwaiter&) = delete;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> coroutine) {
+                RecvWaiter* receiver = nullptr;
+                {
+                    std::scoped_lock lock{ channel.mutex };
+                    if (channel.closed) return false;
+
+                    if (!channel.place(value, receiver)) {
+                        waiter.handle = coroutine;
+                        waiter.thread = std::this_thread::get_id();
+                        channel.senders.push_back(&waiter);
+                        return true;
+                    }
+
+                    waiter.sent = true;
+                }
+
+                if (receiver) post(receiver->thread, receiver->handle);
+                return false;
+            }
+
+            bool await_resume() const noexcept {
+                return waiter.sent;
+            }
+        };
+
+        // Awaitable that receives a value, returning nothing once the channel is closed and empty.
+        class [[nodiscard]] RecvAwaiter {
+            Channel& channel;
+            std::optional<T> value;
+            RecvWaiter waiter{ &value };
+
+        public:
+            explicit RecvAwaiter(Channel& channel) : channel(channel) {}
+
+            // The channel refers to the value in this object while it waits
+            RecvAwaiter(const RecvAwaiter&) = delete;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> coroutine) {
+                SendWaiter* sender = nullptr;
+                {
+                    std::scoped_lock lock{ channel.mutex };
+                    value = channel.take(sender);
+
+                    if (!value && !channel.closed) {
+                        waiter.handle = coroutine;
+                        waiter.thread = std::this_thread::get_id();
+                        channel.receivers.push_back(&waiter);
+                        return true;
+                    }
+                }
+
+                if (sender) post(sender->thread, sender->handle);
+                return false;
+            }
+
+            std::optional<T> await_resume() {
+                return std::move(value);
+            }
+        };
+
+        // Constructs a channel that holds up to a number of values. With a capacity of 0, each sender waits until a
+        // receiver takes its value.
+        explicit Channel(std::size_t capacity) : capacity(capacity) {}
+
+        Channel(const Channel&) = delete;
+
+        Channel& operator=(const Channel&) = delete;
+
+        // Sends a value, waiting while the channel is full.
+        SendAwaiter send(T value) {
+            return { *this, std::move(value) };
+        }
+
+        // Receives a value, waiting while the channel is empty.
+        RecvAwaiter recv() {
+            return RecvAwaiter{ *this };
+        }
+
+        // Sends a value without waiting, from any thread (including threads without event loops).
+        // Returns false if the channel is full or closed, in which case the value is not moved from.
+        bool trySend(T&& value) {
+            RecvWaiter* receiver = nullptr;
+            {
+                std::scoped_lock lock{ mutex };
+                if (closed || !place(value, receiver)) return false;
+            }
+
+            if (receiver) post(receiver->thread, receiver->handle);
+            return true;
+        }
+
+        // Receives a value without waiting, from any thread. Returns nothing if the channel is empty.
+        std::optional<T> tryRecv() {
+            SendWaiter* sender = nullptr;
+            std::optional<T> value;
+            {
+                std::scoped_lock lock{ mutex };
+                value = take(sender);
+            }
+
+            if (sender) post(sender->thread, sender->handle);
+            return value;
+        }
+
+        // Closes the channel. Waiting senders return false, and receivers return the remaining values, then nothing.
+        void close() {
+            std::deque<SendWaiter*> waitingSenders;
+            std::deque<RecvWaiter*> waitingReceivers;
+            {
+                std::scoped_lock lock{ mutex };
+                closed = true;
+                std::swap(waitingSenders, senders);
+                std::swap(waitingReceivers, receivers);
+            }
+
+            for (auto sender : waitingSenders) post(sender->thread, sender->handle);
+            for (auto receiver : waitingReceivers) post(receiver->thread, receiver->handle);
+        }
+    };
+}
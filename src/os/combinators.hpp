@@ -0,0 +1,174 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "utils/task.hpp"
+
+// Functions to await several tasks at once.
+// Tasks start when they are called, so they already run concurrently when they are passed here. Each task resumes on
+// the event loop of the thread that started its operations, so the tasks must be started on the thread that awaits
+// them, and must not move to another executor.
+namespace Async {
+    // Exception thrown when one or more tasks awaited together fail.
+    class TaskErrors : public std::exception {
+        std::vector<std::exception_ptr> errors;
+        std::string message;
+
+    public:
+        explicit TaskErrors(std::vector<std::exception_ptr> errors) :
+            errors(std::move(errors)), message(std::format("{} task(s) failed", this->errors.size())) {}
+
+        const char* what() const noexcept override {
+            return message.c_str();
+        }
+
+        // Gets the exceptions thrown by the tasks, in the order of the tasks.
+        const std::vector<std::exception_ptr>& getErrors() const {
+            return errors;
+        }
+    };
+
+    // Result of the first task to complete in whenAny.
+    template <class T>
+    struct AnyResult {
+        std::size_t index; // Index of the task in the vector passed to whenAny
+        T value;
+    };
+
+    // State shared between whenAny and the coroutines watching each task.
+    template <class T>
+    struct AnyState {
+        std::size_t remaining; // Number of tasks still running
+        std::vector<bool> done; // If each task has ended
+        std::optional<std::size_t> winner; // Index of the first task to complete
+        std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> value; // Value of the first task
+        std::exception_ptr exception; // Exception thrown by the first task
+        std::coroutine_handle<> waiter; // Coroutine suspended in whenAny
+
+        // Suspends whenAny until the winner is known, then until the remaining tasks end.
+        struct Wait {
+            AnyState& state;
+            bool all;
+
+            [[nodiscard]] bool await_ready() const noexcept {
+                return all ? state.remaining == 0 : state.winner.has_value();
+            }
+
+            void await_suspend(std::coroutine_handle<> coroutine) const noexcept {
+                state.waiter = coroutine;
+            }
+
+            void await_resume() const noexcept {}
+        };
+    };
+
+    // Awaits a task for whenAny, recording its result if it completed first.
+    template <class T>
+    Task<> watchTask(Task<T>& task, std::size_t index, AnyState<T>& state) {
+        bool first = false;
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await task;
+                first = !state.winner;
+            } else {
+                T value = co_await task;
+                if ((first = !state.winner)) state.value.emplace(std::move(value));
+            }
+        } catch (...) {
+            if ((first = !state.winner)) state.exception = std::current_exception();
+        }
+
+        if (first) state.winner = index;
+        state.done[index] = true;
+        state.remaining--;
+
+        // whenAny may return while it is resumed, so the state is not touched after this
+        if (first || state.remaining == 0) {
+            if (auto waiter = std::exchange(state.waiter, nullptr)) waiter.resume();
+        }
+    }
+
+    // Awaits all tasks and returns their values in order. Tasks that fail do not stop the others from being awaited;
+    // once all tasks end, a TaskErrors exception is thrown if any of them failed.
+    template <class T>
+    requires (!std::is_void_v<T>)
+    Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+        std::vector<T> values;
+        std::vector<std::exception_ptr> errors;
+        values.reserve(tasks.size());
+
+        for (auto& task : tasks) {
+            try {
+                T value = co_await task;
+                values.push_back(std::move(value));
+            } catch (...) {
+                errors.push_back(std::current_exception());
+            }
+        }
+
+        if (!errors.empty()) throw TaskErrors{ std::move(errors) };
+        co_return values;
+    }
+
+    // Awaits all tasks that do not return values.
+    inline Task<> whenAll(std::vector<Task<>> tasks) {
+        std::vector<std::exception_ptr> errors;
+
+        for (auto& task : tasks) {
+            try {
+                co_await task;
+            } catch (...) {
+                errors.push_back(std::current_exception());
+            }
+        }
+
+        if (!errors.empty()) throw TaskErrors{ std::move(errors) };
+    }
+
+    // Awaits the first task to complete. The cancel function is then called with the index of each task that is still
+    // running, so it can be stopped (e.g. by canceling I/O on its socket), and whenAny waits for those tasks to end so
+    // nothing they refer to is destroyed early. If the first task failed, its exception is rethrown. Exceptions from
+    // the other tasks are discarded.
+    // Returns the index of the first task, and its value if it has one.
+    template <class T>
+    Task<std::conditional_t<std::is_void_v<T>, std::size_t, AnyResult<T>>> whenAny(std::vector<Task<T>> tasks,
+        std::function<void(std::size_t)> cancel) {
+        if (tasks.empty()) throw std::invalid_argument{ "whenAny requires at least one task" };
+
+        AnyState<T> state{ .remaining = tasks.size(), .done = std::vector<bool>(tasks.size()) };
+        std::vector<Task<>> watchers;
+        watchers.reserve(tasks.size());
+        for (std::size_t i = 0; i < tasks.size(); i++) watchers.push_back(watchTask(tasks[i], i, state));
+
+        co_await typename AnyState<T>::Wait{ state, false };
+
+        // Stop the losers and wait for them, even if canceling fails, since they refer to the state in this frame
+        std::exception_ptr cancelError;
+        try {
+            for (std::size_t i = 0; i < tasks.size(); i++)
+                if (!state.done[i]) cancel(i);
+        } catch (...) {
+            cancelError = std::current_exception();
+        }
+
+        co_await typename AnyState<T>::Wait{ state, true };
+
+        if (cancelError) std::rethrow_exception(cancelError);
+        if (state.exception) std::rethrow_exception(state.exception);
+        if constexpr (std::is_void_v<T>) co_return *state.winner;
+        else co_return AnyResult<T>{ *state.winner, std::move(*state.value) };
+    }
+}
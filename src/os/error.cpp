@@ -100,7 +100,7 @@ std::string System::formatSystemError(ErrorCode code, ErrorType type, const std:
     return std::format("{} (type {}, at {}): {}", code, getErrorName(type), where, msg);
 }
 
-bool System::SystemError::isCanceled() const {
+bool System::Error::isCanceled() const {
 #if OS_WINDOWS
     if (type == System::ErrorType::System && code == WSA_OPERATION_ABORTED) return true;
 #else
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <expected>
 #include <source_location>
 #include <stdexcept>
 #include <string>
@@ -34,6 +35,29 @@ namespace System {
     // Formats a system error into a readable string.
     std::string formatSystemError(ErrorCode code, ErrorType type, const std::source_location& location);
 
+    // Error returned instead of thrown. It is only formatted when it is displayed, so returning it is cheap.
+    struct Error {
+        ErrorCode code = 0; // The platform-specific error code
+        ErrorType type = ErrorType::System; // The type of the error
+
+        // Checks if this object represents a fatal error.
+        explicit operator bool() const {
+            return isFatal(code);
+        }
+
+        // Checks if this error represents a canceled operation.
+        bool isCanceled() const;
+
+        // Formats the error into a readable string.
+        std::string format(const std::source_location& location = std::source_location::current()) const {
+            return formatSystemError(code, type, location);
+        }
+    };
+
+    // Result of a function that returns errors instead of throwing them, for use on hot paths.
+    template <class T>
+    using Expected = std::expected<T, Error>;
+
     // Exception structure containing details of an error.
     struct SystemError : std::runtime_error {
         ErrorCode code = 0; // The platform-specific error code
@@ -45,12 +69,24 @@ namespace System {
             std::runtime_error(formatSystemError(code, type, location)),
             code(code), type(type) {}
 
+        // Constructs an object from a returned error.
+        explicit SystemError(const Error& error,
+            const std::source_location& location = std::source_location::current()) :
+            SystemError(error.code, error.type, location) {}
+
         // Checks if this object represents a fatal error.
         explicit operator bool() const {
             return isFatal(code);
         }
 
         // Checks if this exception represents a canceled operation.
-        bool isCanceled() const;
+        bool isCanceled() const {
+            return getError().isCanceled();
+        }
+
+        // Gets the code and type of the error.
+        Error getError() const {
+            return { code, type };
+        }
     };
 }
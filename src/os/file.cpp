@@ -0,0 +1,75 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "file.hpp"
+
+#include <string>
+#include <utility>
+
+#include "async.hpp"
+#include "utils/task.hpp"
+
+Traits::SocketHandleType<SocketTag::IP> File::getOperationHandle(Handle file) {
+#if OS_WINDOWS
+    // Operations store handles as sockets, which are pointer-sized integers
+    return reinterpret_cast<SOCKET>(file);
+#else
+    return file;
+#endif
+}
+
+File::~File() {
+    if (isOpen()) Async::submit(Async::CloseFile{ { getOperationHandle(handle), nullptr } });
+}
+
+Task<> File::open(std::string path, Async::FileMode mode) {
+    if (isOpen()) co_await close();
+
+#if OS_WINDOWS
+    Handle opened = invalidHandle;
+    co_await Async::run([&path, mode, &opened](Async::CompletionResult& result) {
+        Async::submit(Async::OpenFile{ { INVALID_SOCKET, &result }, path.c_str(), mode, &opened });
+    });
+
+    handle = opened;
+#else
+    auto result = co_await Async::run([&path, mode](Async::CompletionResult& result) {
+        Async::submit(Async::OpenFile{ { invalidHandle, &result }, path.c_str(), mode });
+    });
+
+    handle = result.res;
+#endif
+}
+
+Task<std::string> File::read(std::size_t size, std::int64_t offset) {
+    std::string data(size, 0);
+
+    auto result = co_await Async::run([this, &data, offset](Async::CompletionResult& result) {
+        Async::submit(Async::ReadFile{ { getOperationHandle(handle), &result }, data, offset });
+    });
+
+    data.resize(result.res);
+    co_return data;
+}
+
+Task<std::size_t> File::write(std::string data, std::int64_t offset) {
+    auto result = co_await Async::run([this, &data, offset](Async::CompletionResult& result) {
+        Async::submit(Async::WriteFile{ { getOperationHandle(handle), &result }, data, offset });
+    });
+
+    co_return result.res;
+}
+
+Task<> File::sync() {
+    co_await Async::run([this](Async::CompletionResult& result) {
+        Async::submit(Async::SyncFile{ { getOperationHandle(handle), &result } });
+    });
+}
+
+Task<> File::close() {
+    Handle closing = std::exchange(handle, invalidHandle);
+
+    co_await Async::run([closing](Async::CompletionResult& result) {
+        Async::submit(Async::CloseFile{ { getOperationHandle(closing), &result } });
+    });
+}
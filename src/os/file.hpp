@@ -0,0 +1,77 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "async.hpp"
+#include "net/enums.hpp"
+#include "sockets/delegates/traits.hpp"
+#include "utils/task.hpp"
+
+// A file that is read and written through the event loops.
+// With io_uring, disk I/O runs in the kernel without blocking the calling thread.
+class File {
+#if OS_WINDOWS
+    using Handle = HANDLE;
+    static inline const Handle invalidHandle = INVALID_HANDLE_VALUE;
+#else
+    using Handle = int;
+    static constexpr Handle invalidHandle = -1;
+#endif
+
+    Handle handle = invalidHandle;
+
+    // Gets the handle in the form that operations store it.
+    static Traits::SocketHandleType<SocketTag::IP> getOperationHandle(Handle file);
+
+public:
+    File() = default;
+
+    // Closes the file without waiting.
+    ~File();
+
+    File(const File&) = delete;
+
+    // Constructs an object and transfers ownership from another object.
+    File(File&& other) noexcept : handle(std::exchange(other.handle, invalidHandle)) {}
+
+    File& operator=(const File&) = delete;
+
+    // Transfers ownership from another object.
+    File& operator=(File&& other) noexcept {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+
+    // Opens a file, closing any file that was previously open.
+    Task<> open(std::string path, Async::FileMode mode);
+
+    // Reads up to a number of bytes at an offset, or at the file position if the offset is -1.
+    // Returns an empty string at the end of the file.
+    Task<std::string> read(std::size_t size, std::int64_t offset = -1);
+
+    // Writes data at an offset, or at the file position if the offset is -1.
+    // Returns the number of bytes written.
+    Task<std::size_t> write(std::string data, std::int64_t offset = -1);
+
+    // Flushes written data to disk.
+    Task<> sync();
+
+    // Closes the file and waits for the result.
+    Task<> close();
+
+    // Checks if a file is open.
+    bool isOpen() const {
+        return handle != invalidHandle;
+    }
+
+    // Gets the native file handle.
+    const Handle& operator*() const {
+        return handle;
+    }
+};
@@ -0,0 +1,73 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// File operations shared by the POSIX event loop backends.
+
+#pragma once
+
+#include <cerrno>
+#include <variant>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "async.hpp"
+#include "utils/overload.hpp"
+
+// Permissions of files created by OpenFile operations (before the umask is applied)
+constexpr mode_t newFileMode = 0644;
+
+// Gets the flags to pass to open() for a file mode.
+inline int getOpenFlags(Async::FileMode mode) {
+    switch (mode) {
+        case Async::FileMode::Write:
+            return O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        case Async::FileMode::Append:
+            return O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+        default:
+            return O_RDONLY | O_CLOEXEC;
+    }
+}
+
+// Runs a file operation synchronously and stores its result, for backends that cannot wait for disk I/O.
+// Returns false without doing anything if the operation is not a file operation.
+inline bool runFileOperation(const Async::Operation& operation) {
+    ssize_t rc = 0;
+
+    Overload visitor{
+        [&](const Async::OpenFile& op) {
+            rc = open(op.path, getOpenFlags(op.mode), newFileMode);
+            return true;
+        },
+        [&](const Async::ReadFile& op) {
+            rc = op.offset < 0 ? read(op.handle, op.data.data(), op.data.size())
+                               : pread(op.handle, op.data.data(), op.data.size(), op.offset);
+            return true;
+        },
+        [&](const Async::WriteFile& op) {
+            rc = op.offset < 0 ? write(op.handle, op.data.data(), op.data.size())
+                               : pwrite(op.handle, op.data.data(), op.data.size(), op.offset);
+            return true;
+        },
+        [&](const Async::SyncFile& op) {
+            rc = fsync(op.handle);
+            return true;
+        },
+        [&](const Async::CloseFile& op) {
+            rc = close(op.handle);
+            return true;
+        },
+        [](const auto&) { return false; },
+    };
+
+    if (!std::visit(visitor, operation)) return false;
+
+    // Files can be closed without waiting for the result
+    auto result = std::visit([](const Async::OperationBase& base) { return base.result; }, operation);
+    if (!result) return true;
+
+    if (rc == -1) result->error = errno;
+    else result->res = static_cast<int>(rc);
+
+    return true;
+}
@@ -0,0 +1,137 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "utils/framepool.hpp"
+#include "utils/task.hpp"
+
+namespace Async {
+    // Coroutine that produces a sequence of values with co_yield, each of which can be awaited asynchronously.
+    // The coroutine starts when the first value is requested and runs until its next co_yield, so a loop over a stream
+    // of values keeps a single coroutine frame instead of creating one per value.
+    // Values are awaited with next(), which is linked like an awaited task: cancellation tokens reach operations
+    // awaited inside the generator, and canceling one stops the coroutine awaiting the generator.
+    // T: the datatype of the values produced by the coroutine
+    template <class T>
+    class [[nodiscard]] Generator {
+        struct PromiseType : TaskPromiseBase {
+            // Returns control to the coroutine that requested the value.
+            struct YieldAwaiter {
+                [[nodiscard]] bool await_ready() const noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> current) const noexcept {
+                    auto& promise = current.promise();
+                    if (promise.parent) promise.parent->awaitedTask = nullptr;
+                    return promise.continuation ? promise.continuation : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::optional<T> value; // The value from the last co_yield, until it is taken
+            std::exception_ptr exception; // Any exception that was thrown in the coroutine
+
+            // Allocates the coroutine frame from the freelists of the current thread.
+            static void* operator new(std::size_t size) {
+                return FramePool::allocateFrame(size);
+            }
+
+            static void operator delete(void* p, std::size_t size) noexcept {
+                FramePool::deallocateFrame(p, size);
+            }
+
+            Generator get_return_object() noexcept {
+                return Generator{ std::coroutine_handle<PromiseType>::from_promise(*this) };
+            }
+
+            // Generators do not run until the first value is requested.
+            [[nodiscard]] std::suspend_always initial_suspend() const noexcept {
+                return {};
+            }
+
+            YieldAwaiter yield_value(T yielded) {
+                value.emplace(std::move(yielded));
+                return {};
+            }
+
+            void return_void() const noexcept {}
+
+            void unhandled_exception() noexcept {
+                exception = std::current_exception();
+            }
+
+            // The frame stays alive after completion since the generator object owns it.
+            YieldAwaiter final_suspend() const noexcept {
+                return {};
+            }
+        };
+
+        std::coroutine_handle<PromiseType> handle;
+
+        explicit Generator(std::coroutine_handle<PromiseType> handle) : handle(handle) {}
+
+    public:
+        // Type alias for the promise object for use by the compiler.
+        using promise_type = PromiseType;
+
+        // Awaitable that resumes the coroutine until its next value.
+        class [[nodiscard]] NextAwaiter {
+            std::coroutine_handle<PromiseType> handle;
+
+        public:
+            explicit NextAwaiter(std::coroutine_handle<PromiseType> handle) : handle(handle) {}
+
+            [[nodiscard]] bool await_ready() const noexcept {
+                return handle.done();
+            }
+
+            template <class Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> current) const {
+                handle.promise().setContinuation(current);
+                return handle;
+            }
+
+            // Returns the next value, or nothing if the coroutine has completed.
+            std::optional<T> await_resume() const {
+                auto& promise = handle.promise();
+                if (auto exception = std::exchange(promise.exception, nullptr)) std::rethrow_exception(exception);
+                return std::exchange(promise.value, std::nullopt);
+            }
+        };
+
+        Generator(Generator&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        Generator& operator=(Generator&& other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        Generator(const Generator&) = delete;
+
+        Generator& operator=(const Generator&) = delete;
+
+        // Destroys the coroutine frame. It can be suspended in the middle of an operation if the coroutine requesting
+        // values was stopped by a cancellation.
+        ~Generator() {
+            if (handle) handle.destroy();
+        }
+
+        // Requests the next value. The awaited result is empty once the coroutine completes, and exceptions thrown in
+        // the coroutine are rethrown from it.
+        NextAwaiter next() const {
+            return NextAwaiter{ handle };
+        }
+    };
+}
@@ -0,0 +1,171 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "async.hpp"
+#include "utils/cancellation.hpp"
+#include "utils/task.hpp"
+
+namespace Async {
+    // Blocking work queued to the offload threads.
+    class OffloadJob {
+    public:
+        // Runs the work, then resumes the coroutine that queued it.
+        virtual void run() = 0;
+
+        // Resumes the coroutine that queued the work with an error, without running the work.
+        virtual void fail(std::exception_ptr error) = 0;
+
+    protected:
+        ~OffloadJob() = default;
+    };
+
+    // Queues a job to run on the offload threads. A thread is started if all existing ones are busy, up to a limit;
+    // past that, jobs wait for a thread to become free. The job must stay alive until it resumes its coroutine.
+    void queueOffload(OffloadJob& job);
+
+    // Coroutine that starts when its handle is resumed, and destroys its frame when it finishes.
+    struct DetachedCoroutine {
+        struct promise_type {
+            DetachedCoroutine get_return_object() {
+                return { std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+
+            std::suspend_always initial_suspend() const noexcept {
+                return {};
+            }
+
+            std::suspend_never final_suspend() const noexcept {
+                return {};
+            }
+
+            void return_void() const noexcept {}
+
+            void unhandled_exception() const noexcept {
+                std::terminate();
+            }
+        };
+
+        std::coroutine_handle<> handle;
+    };
+
+    // Awaitable that runs a blocking function on the offload threads and returns its result.
+    // The awaiting coroutine is suspended while the function runs, then resumed on the thread it was on. Exceptions
+    // thrown from the function are rethrown from the co_await expression.
+    // When it is awaited in a task run with withCancellation, canceling the token ends the stopped tasks right away,
+    // since blocking work cannot be interrupted. The function still runs to completion and its result is dropped, so
+    // it must not refer to the awaiting coroutine's frame (e.g. by capturing its locals by reference).
+    template <class Fn>
+    class [[nodiscard]] OffloadAwaiter final : CancelCallback {
+        using Result = std::invoke_result_t<Fn&>;
+
+        // State shared with the offload threads, which outlives the awaiter if it is canceled
+        struct Job final : OffloadJob {
+            Fn fn;
+            std::optional<std::conditional_t<std::is_void_v<Result>, bool, Result>> result;
+            std::exception_ptr exception;
+            std::coroutine_handle<> coroutine; // Changed only on the awaiting thread once the job is queued
+            std::thread::id thread; // The thread to resume the coroutine on
+            std::shared_ptr<Job> self; // Keeps the job alive until the coroutine is resumed
+
+            explicit Job(Fn fn) : fn(std::move(fn)) {}
+
+            // Resumes the coroutine on its own thread, which is where a cancellation can replace it.
+            static DetachedCoroutine resume(Job* job) {
+                auto keepAlive = std::move(job->self);
+                job->coroutine.resume();
+                co_return;
+            }
+
+            void run() override {
+                try {
+                    if constexpr (std::is_void_v<Result>) {
+                        std::invoke(fn);
+                        result = true;
+                    } else {
+                        result.emplace(std::invoke(fn));
+                    }
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+
+                post(thread, resume(this).handle);
+            }
+
+            void fail(std::exception_ptr error) override {
+                exception = error;
+                post(thread, resume(this).handle);
+            }
+        };
+
+        std::shared_ptr<Job> job;
+        TaskPromiseBase* promise = nullptr; // The awaiting task, if it can be canceled
+
+        void onCancel() override {
+            // The result is dropped when the job finishes, and control goes to withCancellation on the next iteration
+            // of the event loop
+            job->coroutine = std::noop_coroutine();
+            post(std::this_thread::get_id(), promise->stop());
+        }
+
+    public:
+        explicit OffloadAwaiter(Fn fn) : job(std::make_shared<Job>(std::move(fn))) {}
+
+        [[nodiscard]] bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> awaiting) {
+            if constexpr (std::is_base_of_v<TaskPromiseBase, Promise>) {
+                promise = &awaiting.promise();
+
+                // Nothing is queued if the task was canceled before it got here
+                if (promise->cancelToken.isCanceled()) return promise->stop();
+
+                promise->pendingOperation = this;
+                attach(promise->cancelToken);
+            }
+
+            job->coroutine = awaiting;
+            job->thread = std::this_thread::get_id();
+            job->self = job;
+
+            try {
+                queueOffload(*job);
+            } catch (...) {
+                // Nothing was queued, so the awaiter is not pending
+                if (promise) promise->pendingOperation = nullptr;
+                detach();
+                job->self.reset();
+                throw;
+            }
+
+            return std::noop_coroutine();
+        }
+
+        Result await_resume() {
+            if (promise) promise->pendingOperation = nullptr;
+            detach();
+
+            if (job->exception) std::rethrow_exception(job->exception);
+            if constexpr (!std::is_void_v<Result>) return std::move(*job->result);
+        }
+    };
+
+    // Runs a blocking function (e.g. a name lookup or a call that waits for a device) without blocking the event loop.
+    template <class Fn>
+    OffloadAwaiter<Fn> offload(Fn fn) {
+        return OffloadAwaiter<Fn>{ std::move(fn) };
+    }
+}
@@ -0,0 +1,20 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "utils/task.hpp"
+
+namespace Async {
+    // Moves data from one file descriptor to another through a pipe, so it is not copied through user space (Linux
+    // only). Stops after a number of bytes, or when the source reaches its end.
+    // The offset is where a file source is read from, or -1 to use its position. The counter is increased as data
+    // reaches the destination.
+    // Returns false if the event loop cannot splice, which is only reported before any data has been moved.
+    Task<bool> spliceData(int from, int to, std::uint64_t& counter,
+        std::size_t size = std::numeric_limits<std::size_t>::max(), std::int64_t offset = -1);
+}
@@ -0,0 +1,99 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "splice.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "async.hpp"
+#include "errcheck.hpp"
+#include "error.hpp"
+#include "utils/task.hpp"
+
+// Maximum number of bytes to splice at once (the default capacity of a pipe)
+constexpr std::size_t pipeSize = 65536;
+
+// A pipe that is closed when it goes out of scope.
+class Pipe {
+    int fds[2];
+
+public:
+    Pipe() {
+        check(pipe2(fds, O_CLOEXEC));
+    }
+
+    ~Pipe() {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    Pipe(const Pipe&) = delete;
+
+    Pipe& operator=(const Pipe&) = delete;
+
+    // Gets the end that data is read from.
+    int readEnd() const {
+        return fds[0];
+    }
+
+    // Gets the end that data is written to.
+    int writeEnd() const {
+        return fds[1];
+    }
+};
+
+// Checks if a file descriptor refers to a socket.
+bool isSocket(int fd) {
+    struct stat info;
+    return fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode);
+}
+
+Task<bool> Async::spliceData(int from, int to, std::uint64_t& counter, std::size_t size, std::int64_t offset) {
+    Pipe pipe;
+    std::size_t moved = 0;
+
+    // io_uring runs splices that would block on worker threads, waiting for data first keeps them on the event loop
+    // (files are always ready)
+    bool waitFirst = getBackend() == Backend::IOUring && isSocket(from);
+
+    try {
+        while (moved < size) {
+            if (waitFirst) co_await readable(from);
+
+            auto in = co_await run([&](CompletionResult& result) {
+                std::int64_t fromOffset = offset < 0 ? -1 : offset + static_cast<std::int64_t>(moved);
+                submit(Splice{ { from, &result }, pipe.writeEnd(), true, std::min(size - moved, pipeSize),
+                    fromOffset });
+            });
+
+            if (in.res == 0) break;
+
+            // Drain the pipe before it is filled again
+            for (auto pending = static_cast<std::size_t>(in.res); pending > 0;) {
+                auto out = co_await run([&](CompletionResult& result) {
+                    submit(Splice{ { to, &result }, pipe.readEnd(), false, pending });
+                });
+
+                // The rest of the pipe cannot be moved if the destination closed its connection
+                if (out.res == 0) throw System::SystemError{ EPIPE, System::ErrorType::System };
+
+                pending -= out.res;
+                moved += out.res;
+                counter += out.res;
+            }
+        }
+    } catch (const System::SystemError& e) {
+        // The caller can fall back to copying if the event loop cannot splice and nothing has been moved
+        if (e.code != EOPNOTSUPP || moved > 0) throw;
+        co_return false;
+    }
+
+    co_return true;
+}
@@ -24,3 +24,4 @@ public:
 
 using ClientSocketIP = ClientSocket<SocketTag::IP>;
 using ClientSocketBT = ClientSocket<SocketTag::BT>;
+using ClientSocketUnix = ClientSocket<SocketTag::Unix>;
@@ -3,24 +3,67 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <type_traits>
 
 #include "delegates.hpp"
 #include "sockethandle.hpp"
+#include "os/error.hpp"
+#include "os/file.hpp"
 #include "utils/task.hpp"
 
 namespace Delegates {
     // Manages bidirectional communication on a socket.
     template <auto Tag>
-    class Bidirectional : public IODelegate {
+    class Bidirectional final : public IODelegate {
         SocketHandle<Tag>& handle;
 
+#if !OS_MACOS
+        // Result of an operation that either throws its errors or returns them.
+        template <bool Throws, class T>
+        using IOResult = std::conditional_t<Throws, T, System::Expected<T>>;
+
+        // Sends a string. The throwing and non-throwing versions both return this task, so neither awaits the other.
+        template <bool Throws>
+        Task<IOResult<Throws, void>> sendData(std::string data);
+
+        // Receives a string. The throwing and non-throwing versions both return this task.
+        template <bool Throws>
+        Task<IOResult<Throws, RecvResult>> recvData(std::size_t size);
+#endif
+
+#if OS_LINUX
+        std::uint64_t txTimestamp = 0; // Latest transmit timestamp read from the socket
+        std::uint64_t txTimestampCount = 0; // Number of transmit timestamps read from the socket
+
+        // Reads all transmit timestamps queued on the socket without waiting. Returns if any were read.
+        bool readTxTimestamps();
+
+        // Waits for a transmit timestamp to be queued on the socket, up to a time limit, then reads it.
+        Task<> waitTxTimestamp();
+#endif
+
     public:
         explicit Bidirectional(SocketHandle<Tag>& handle) : handle(handle) {}
 
         Task<> send(std::string data) override;
 
         Task<RecvResult> recv(std::size_t size) override;
+
+#if !OS_MACOS
+        Task<System::Expected<void>> trySend(std::string data) override;
+
+        Task<System::Expected<RecvResult>> tryRecv(std::size_t size) override;
+#endif
+
+#if OS_LINUX
+        // Waits for the kernel to transmit the data if the timestamps option is set, and returns the transmit time.
+        Task<std::uint64_t> sendTimestamped(std::string data) override;
+
+        // Splices the file into the socket through a pipe, so the data is not copied through user space.
+        Task<std::size_t> sendFile(File& file, std::int64_t offset, std::size_t size) override;
+#endif
     };
 }
@@ -11,7 +11,7 @@
 namespace Delegates {
     // Manages operations on client sockets.
     template <auto Tag>
-    class Client : public ClientDelegate {
+    class Client final : public ClientDelegate {
         SocketHandle<Tag>& handle;
 
     public:
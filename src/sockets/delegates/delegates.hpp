@@ -3,13 +3,19 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 
 #include "net/device.hpp"
 #include "net/enums.hpp"
+#include "os/error.hpp"
+#include "os/file.hpp"
+#include "os/generator.hpp"
 #include "utils/task.hpp"
 
 class Socket;
@@ -26,6 +32,7 @@ struct RecvResult {
     bool closed;
     std::string data;
     std::optional<TLSAlert> alert;
+    std::uint64_t timestamp = 0; // Time the kernel received the data in nanoseconds since the Unix epoch, 0 if unknown
 };
 
 struct AcceptResult {
@@ -36,6 +43,7 @@ struct AcceptResult {
 struct DgramRecvResult {
     Device from;
     std::string data;
+    std::uint64_t timestamp = 0; // Time the kernel received the data in nanoseconds since the Unix epoch, 0 if unknown
 };
 
 struct ServerAddress {
@@ -43,6 +51,29 @@ struct ServerAddress {
     IPType ipType = IPType::None;
 };
 
+// Options applied to a socket when its handle is created.
+// Options that can change on an open socket are also applied immediately when set. Default (zero) values leave the
+// system setting unchanged.
+struct SocketOptions {
+    bool fastOpen = false; // Use TCP Fast Open (client data is sent with the SYN, servers accept data in the SYN)
+    bool deferAccept = false; // Only complete accepts once the client has sent data (Linux TCP servers only)
+    bool noDelay = false; // Disable Nagle's algorithm (TCP only)
+    bool quickAck = false; // Acknowledge received data immediately instead of delaying ACKs (Linux TCP only)
+    std::uint32_t recvBufSize = 0; // Kernel receive buffer size in bytes (0 for system default)
+    std::uint32_t sendBufSize = 0; // Kernel send buffer size in bytes (0 for system default)
+    std::uint32_t busyPoll = 0; // Time to busy poll for received data in microseconds (0 to disable, Linux only)
+    std::uint32_t maxPacingRate = 0; // Maximum transmit rate in bytes per second (0 for unlimited, Linux only)
+    bool timestamps = false; // Record kernel receive and transmit times of data (Linux IP sockets only)
+
+    bool operator==(const SocketOptions&) const = default;
+};
+
+// Gets the current time in nanoseconds since the Unix epoch, the unit of kernel timestamps.
+inline std::uint64_t getTimeNow() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
 namespace Delegates {
     // Manages handle operations.
     struct HandleDelegate {
@@ -56,6 +87,9 @@ namespace Delegates {
 
         // Cancels all pending I/O.
         virtual void cancelIO() = 0;
+
+        // Sets the options to apply when the socket is created, and applies them if it is already open.
+        virtual void setOptions(const SocketOptions& options) = 0;
     };
 
     // Manages I/O operations.
@@ -68,8 +102,61 @@ namespace Delegates {
 
         // Receives a string.
         virtual Task<RecvResult> recv(std::size_t size) = 0;
+
+        // Sends a string, returning errors instead of throwing them.
+        // By default, errors thrown by send are caught. Delegates on the hot path override this to avoid exceptions.
+        virtual Task<System::Expected<void>> trySend(std::string data) {
+            try {
+                co_await send(std::move(data));
+            } catch (const System::SystemError& e) {
+                co_return std::unexpected{ e.getError() };
+            }
+            co_return {};
+        }
+
+        // Receives a string, returning errors instead of throwing them.
+        // By default, errors thrown by recv are caught. Delegates on the hot path override this to avoid exceptions.
+        virtual Task<System::Expected<RecvResult>> tryRecv(std::size_t size) {
+            try {
+                co_return co_await recv(size);
+            } catch (const System::SystemError& e) {
+                co_return std::unexpected{ e.getError() };
+            }
+        }
+
+        // Sends a string and returns the time it was transmitted in nanoseconds since the Unix epoch.
+        // By default, this is the time the send completed.
+        virtual Task<std::uint64_t> sendTimestamped(std::string data) {
+            co_await send(std::move(data));
+            co_return getTimeNow();
+        }
+
+        // Sends up to a number of bytes from a file at an offset, or at the file position if the offset is -1.
+        // Returns the number of bytes sent, or 0 at the end of the file.
+        // By default, the data is read into memory and sent as a string.
+        virtual Task<std::size_t> sendFile(File& file, std::int64_t offset, std::size_t size) {
+            std::string data = co_await file.read(size, offset);
+            std::size_t dataSize = data.size();
+
+            if (dataSize > 0) co_await send(std::move(data));
+            co_return dataSize;
+        }
     };
 
+    // Receives data continuously from one coroutine, yielding each chunk until the connection closes or an error
+    // occurs (both of which are yielded as the last value). Exceptions from the I/O type (e.g. TLS errors) are
+    // rethrown when the value is requested. The I/O object must outlive the generator.
+    template <class IO>
+    Async::Generator<System::Expected<RecvResult>> recvStream(IO& io, std::size_t size) {
+        while (true) {
+            auto result = co_await io.tryRecv(size);
+            bool end = !result || result->closed;
+
+            co_yield std::move(result);
+            if (end) co_return;
+        }
+    }
+
     // Manages client operations.
     struct ClientDelegate {
         virtual ~ClientDelegate() = default;
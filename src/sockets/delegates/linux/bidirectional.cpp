@@ -3,35 +3,263 @@
 
 #include "sockets/delegates/bidirectional.hpp"
 
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #include "net/enums.hpp"
+#include "net/netutils.hpp"
 #include "os/async.hpp"
+#include "os/combinators.hpp"
+#include "os/errcheck.hpp"
+#include "os/error.hpp"
+#include "os/file.hpp"
+#include "os/splice.hpp"
+#include "utils/cancellation.hpp"
 #include "utils/task.hpp"
 
+// Size of the control buffer for messages in the error queue, which carry an extended error after the timestamp
+constexpr std::size_t errorControlSize
+    = NetUtils::timestampControlSize + CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6));
+
+// Maximum time to wait for a transmit timestamp after sending, in seconds
+constexpr int txTimestampTimeout = 5;
+
+// Waits for a file descriptor to report an error event, or to become readable, as a task that can be raced.
+Task<> waitPoll(int fd, bool errors) {
+    if (errors) co_await Async::errored(fd);
+    else co_await Async::readable(fd);
+}
+
+// Checks if the timestamps option is in effect on a socket (it is only applied to IP sockets).
 template <auto Tag>
-Task<> Delegates::Bidirectional<Tag>::send(std::string data) {
-    co_await Async::run([this, &data](Async::CompletionResult& result) {
+bool hasTimestamps(const Delegates::SocketHandle<Tag>& handle) {
+    return Tag == SocketTag::IP && handle.getOptions().timestamps;
+}
+
+template <auto Tag>
+bool Delegates::Bidirectional<Tag>::readTxTimestamps() {
+    bool found = false;
+
+    while (true) {
+        alignas(cmsghdr) std::array<char, errorControlSize> control;
+        msghdr msg{
+            .msg_name = nullptr,
+            .msg_namelen = 0,
+            .msg_iov = nullptr,
+            .msg_iovlen = 0,
+            .msg_control = control.data(),
+            .msg_controllen = control.size(),
+            .msg_flags = 0,
+        };
+
+        if (recvmsg(*handle, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) return found;
+
+        if (std::uint64_t timestamp = NetUtils::getTimestamp(msg)) {
+            txTimestamp = timestamp;
+            txTimestampCount++;
+            found = true;
+        }
+    }
+}
+
+template <auto Tag>
+Task<> Delegates::Bidirectional<Tag>::waitTxTimestamp() {
+    // Queued timestamps make the socket report an error event. No timestamp is queued if the data is never
+    // transmitted, so a timer bounds the wait.
+    int timer = check(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC));
+    itimerspec expiry{ .it_interval = {}, .it_value = { .tv_sec = txTimestampTimeout, .tv_nsec = 0 } };
+    timerfd_settime(timer, 0, &expiry, nullptr);
+
+    std::array<CancelSource, 2> stop;
+    std::vector<Task<bool>> waits;
+    waits.push_back(withCancellation(stop[0].getToken(), waitPoll(*handle, true)));
+    waits.push_back(withCancellation(stop[1].getToken(), waitPoll(timer, false)));
+
+    try {
+        co_await Async::whenAny(std::move(waits), [&stop](std::size_t i) { stop[i].cancel(); });
+    } catch (const System::SystemError&) {
+        // The caller falls back to the current time if the wait failed
+    }
+
+    close(timer);
+
+    // The event may also be a hangup or socket error, which is not waited on again since it stays reported
+    readTxTimestamps();
+}
+
+template <auto Tag>
+template <bool Throws>
+auto Delegates::Bidirectional<Tag>::sendData(std::string data) -> Task<IOResult<Throws, void>> {
+    auto sendResult = co_await Async::tryRun([this, &data](Async::CompletionResult& result) {
         Async::submit(Async::Send{ { *handle, &result }, data });
     });
+
+    if (!sendResult) {
+        if constexpr (Throws) throw System::SystemError{ sendResult.error() };
+        else co_return std::unexpected{ sendResult.error() };
+    }
+
+    if constexpr (!Throws) co_return {};
 }
 
 template <auto Tag>
-Task<RecvResult> Delegates::Bidirectional<Tag>::recv(std::size_t size) {
+Task<> Delegates::Bidirectional<Tag>::send(std::string data) {
+    return sendData<true>(std::move(data));
+}
+
+template <auto Tag>
+Task<System::Expected<void>> Delegates::Bidirectional<Tag>::trySend(std::string data) {
+    return sendData<false>(std::move(data));
+}
+
+template <auto Tag>
+Task<std::uint64_t> Delegates::Bidirectional<Tag>::sendTimestamped(std::string data) {
+    if (!hasTimestamps(handle) || data.empty()) co_return co_await IODelegate::sendTimestamped(std::move(data));
+
+    // Timestamps that are already queued belong to earlier sends
+    readTxTimestamps();
+    std::uint64_t prevCount = txTimestampCount;
+
+    // The transmit timestamp is requested with a control message, so other sends on the socket do not queue any.
+    // Event loops have no sendmsg operation, so it is called directly and waits for the socket when it is full.
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(std::uint32_t))> control{};
+    std::uint32_t txFlags = SOF_TIMESTAMPING_TX_SOFTWARE;
+
+    for (std::size_t sent = 0; sent < data.size();) {
+        iovec iov{
+            .iov_base = data.data() + sent,
+            .iov_len = data.size() - sent,
+        };
+
+        msghdr msg{
+            .msg_name = nullptr,
+            .msg_namelen = 0,
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = control.data(),
+            .msg_controllen = control.size(),
+            .msg_flags = 0,
+        };
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SO_TIMESTAMPING;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(txFlags));
+        std::memcpy(CMSG_DATA(cmsg), &txFlags, sizeof(txFlags));
+
+        ssize_t rc = sendmsg(*handle, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (rc == -1 && errno == EAGAIN) co_await Async::writable(*handle);
+        else sent += check(rc);
+    }
+
+    // The timestamp is queued when the data is passed to the device, which can be after the send completes (e.g. when
+    // TCP waits for its congestion window)
+    if (txTimestampCount == prevCount && !readTxTimestamps()) co_await waitTxTimestamp();
+
+    co_return txTimestampCount != prevCount ? txTimestamp : getTimeNow();
+}
+
+template <auto Tag>
+template <bool Throws>
+auto Delegates::Bidirectional<Tag>::recvData(std::size_t size) -> Task<IOResult<Throws, RecvResult>> {
     std::string data(size, 0);
 
-    auto recvResult = co_await Async::run([this, &data](Async::CompletionResult& result) {
-        Async::submit(Async::Receive{ { *handle, &result }, data });
+    // Timestamps are received as control messages, which need recvmsg
+    bool timestamps = hasTimestamps(handle);
+    alignas(cmsghdr) std::array<char, NetUtils::timestampControlSize> control;
+
+    iovec iov{
+        .iov_base = data.data(),
+        .iov_len = data.size(),
+    };
+
+    msghdr msg{
+        .msg_name = nullptr,
+        .msg_namelen = 0,
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.data(),
+        .msg_controllen = control.size(),
+        .msg_flags = 0,
+    };
+
+    auto recvResult = co_await Async::tryRun([&](Async::CompletionResult& result) {
+        if (timestamps) Async::submit(Async::ReceiveFrom{ { *handle, &result }, &msg });
+        else Async::submit(Async::Receive{ { *handle, &result }, data });
     });
 
-    if (recvResult.res == 0) co_return { true, true, "", std::nullopt };
+    // Transmit timestamps left over from a send that stopped waiting would keep waking up receives
+    if (timestamps) readTxTimestamps();
 
-    data.resize(recvResult.res);
-    co_return { true, false, data, std::nullopt };
+    if (!recvResult) {
+        if constexpr (Throws) throw System::SystemError{ recvResult.error() };
+        else co_return std::unexpected{ recvResult.error() };
+    }
+
+    if (recvResult->res == 0) co_return RecvResult{ true, true, "", std::nullopt };
+
+    // Quick ACK mode is not permanent, so it is re-enabled after every receive
+    if (handle.getOptions().quickAck) {
+        int enable = 1;
+        setsockopt(*handle, IPPROTO_TCP, TCP_QUICKACK, &enable, sizeof(enable));
+    }
+
+    data.resize(recvResult->res);
+    co_return RecvResult{ true, false, data, std::nullopt, timestamps ? NetUtils::getTimestamp(msg) : 0 };
+}
+
+template <auto Tag>
+Task<RecvResult> Delegates::Bidirectional<Tag>::recv(std::size_t size) {
+    return recvData<true>(size);
+}
+
+template <auto Tag>
+Task<System::Expected<RecvResult>> Delegates::Bidirectional<Tag>::tryRecv(std::size_t size) {
+    return recvData<false>(size);
+}
+
+template <auto Tag>
+Task<std::size_t> Delegates::Bidirectional<Tag>::sendFile(File& file, std::int64_t offset, std::size_t size) {
+    std::uint64_t sent = 0;
+    bool spliced = co_await Async::spliceData(*file, *handle, sent, size, offset);
+
+    // The event loop cannot splice, fall back to copying
+    if (!spliced) co_return co_await IODelegate::sendFile(file, offset, size);
+    co_return sent;
 }
 
 template Task<> Delegates::Bidirectional<SocketTag::IP>::send(std::string);
 template Task<RecvResult> Delegates::Bidirectional<SocketTag::IP>::recv(std::size_t);
+template Task<System::Expected<void>> Delegates::Bidirectional<SocketTag::IP>::trySend(std::string);
+template Task<System::Expected<RecvResult>> Delegates::Bidirectional<SocketTag::IP>::tryRecv(std::size_t);
+template Task<std::uint64_t> Delegates::Bidirectional<SocketTag::IP>::sendTimestamped(std::string);
+template Task<std::size_t> Delegates::Bidirectional<SocketTag::IP>::sendFile(File&, std::int64_t, std::size_t);
 
 template Task<> Delegates::Bidirectional<SocketTag::BT>::send(std::string);
 template Task<RecvResult> Delegates::Bidirectional<SocketTag::BT>::recv(std::size_t);
+template Task<System::Expected<void>> Delegates::Bidirectional<SocketTag::BT>::trySend(std::string);
+template Task<System::Expected<RecvResult>> Delegates::Bidirectional<SocketTag::BT>::tryRecv(std::size_t);
+template Task<std::uint64_t> Delegates::Bidirectional<SocketTag::BT>::sendTimestamped(std::string);
+template Task<std::size_t> Delegates::Bidirectional<SocketTag::BT>::sendFile(File&, std::int64_t, std::size_t);
+
+template Task<> Delegates::Bidirectional<SocketTag::Unix>::send(std::string);
+template Task<RecvResult> Delegates::Bidirectional<SocketTag::Unix>::recv(std::size_t);
+template Task<System::Expected<void>> Delegates::Bidirectional<SocketTag::Unix>::trySend(std::string);
+template Task<System::Expected<RecvResult>> Delegates::Bidirectional<SocketTag::Unix>::tryRecv(std::size_t);
+template Task<std::uint64_t> Delegates::Bidirectional<SocketTag::Unix>::sendTimestamped(std::string);
+template Task<std::size_t> Delegates::Bidirectional<SocketTag::Unix>::sendFile(File&, std::int64_t, std::size_t);
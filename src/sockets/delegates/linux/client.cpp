@@ -4,6 +4,7 @@
 #include "sockets/delegates/client.hpp"
 
 #include <functional>
+#include <utility>
 
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/l2cap.h>
@@ -12,8 +13,10 @@
 #include "net/device.hpp"
 #include "net/enums.hpp"
 #include "net/netutils.hpp"
+#include "net/unixutils.hpp"
 #include "os/async.hpp"
 #include "os/errcheck.hpp"
+#include "os/offload.hpp"
 
 void startConnect(int s, sockaddr* addr, socklen_t len, Async::CompletionResult& result) {
     Async::submit(Async::Connect{ { s, &result }, addr, len });
@@ -21,10 +24,15 @@ void startConnect(int s, sockaddr* addr, socklen_t len, Async::CompletionResult&
 
 template <>
 Task<> Delegates::Client<SocketTag::IP>::connect(Device device) {
-    auto addr = NetUtils::resolveAddr(device);
+    // Name lookups can block for a long time, so they do not run on the event loop
+    // The device is copied since the lookup keeps running if this coroutine is canceled and destroyed
+    auto resolve = [device] { return NetUtils::resolveAddr(device); };
+    auto addr = co_await Async::offload(std::move(resolve));
 
-    co_await NetUtils::loopWithAddr(addr.get(), [this](const AddrInfoType* result) -> Task<> {
+    co_await NetUtils::loopWithAddr(addr.get(), [this, type = device.type](const AddrInfoType* result) -> Task<> {
         handle.reset(check(socket(result->ai_family, result->ai_socktype, result->ai_protocol)));
+        NetUtils::setClientOptions(*handle, handle.getOptions(), type == ConnectionType::TCP);
+
         co_await Async::run(std::bind_front(startConnect, *handle, result->ai_addr, result->ai_addrlen));
     });
 }
@@ -48,3 +56,11 @@ Task<> Delegates::Client<SocketTag::BT>::connect(Device device) {
         co_await Async::run(std::bind_front(startConnect, *handle, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
     }
 }
+
+template <>
+Task<> Delegates::Client<SocketTag::Unix>::connect(Device device) {
+    auto addr = UnixUtils::toAddr(device.address);
+    handle.reset(check(socket(AF_UNIX, UnixUtils::getSocketType(device.type), 0)));
+
+    co_await Async::run(std::bind_front(startConnect, *handle, reinterpret_cast<sockaddr*>(&addr.addr), addr.len));
+}
@@ -3,9 +3,10 @@
 
 #include "sockets/delegates/server.hpp"
 
+#include <array>
 #include <functional>
-#include <memory>
 #include <string>
+#include <utility>
 
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/hci.h>
@@ -16,9 +17,10 @@
 
 #include "net/enums.hpp"
 #include "net/netutils.hpp"
+#include "net/unixutils.hpp"
 #include "os/async.hpp"
 #include "os/errcheck.hpp"
-#include "sockets/incomingsocket.hpp"
+#include "os/offload.hpp"
 #include "utils/strings.hpp"
 #include "utils/task.hpp"
 
@@ -28,11 +30,13 @@ void startAccept(int s, sockaddr* clientAddr, socklen_t& clientLen, Async::Compl
 
 template <>
 ServerAddress Delegates::Server<SocketTag::IP>::startServer(const Device& serverInfo) {
-    return NetUtils::startServer(serverInfo, handle);
+    ServerAddress result = NetUtils::startServer(serverInfo, handle);
+    acceptOptions = NetUtils::getAcceptedOptions(handle.getOptions());
+    return result;
 }
 
 template <>
-Task<AcceptResult> Delegates::Server<SocketTag::IP>::accept() {
+Task<Delegates::AcceptHandleResult<SocketTag::IP>> Delegates::Server<SocketTag::IP>::acceptHandle() {
     sockaddr_storage client;
     auto clientAddr = reinterpret_cast<sockaddr*>(&client);
     socklen_t clientLen = sizeof(client);
@@ -41,8 +45,10 @@ Task<AcceptResult> Delegates::Server<SocketTag::IP>::accept() {
 
     Device device = NetUtils::fromAddr(clientAddr, clientLen, ConnectionType::TCP);
     SocketHandle<SocketTag::IP> fd{ acceptResult.res };
+    fd.setInheritedOptions(handle.getOptions());
+    if (acceptOptions) NetUtils::setAcceptedOptions(*fd, *acceptOptions);
 
-    co_return { device, std::make_unique<IncomingSocket<SocketTag::IP>>(std::move(fd)) };
+    co_return { device, std::move(fd) };
 }
 
 template <>
@@ -56,6 +62,9 @@ Task<DgramRecvResult> Delegates::Server<SocketTag::IP>::recvFrom(std::size_t siz
     socklen_t len = sizeof(from);
     std::string data(size, 0);
 
+    // Control messages carry the receive timestamp if the timestamps option is set
+    alignas(cmsghdr) std::array<char, NetUtils::timestampControlSize> control;
+
     iovec iov{
         .iov_base = data.data(),
         .iov_len = data.size(),
@@ -66,8 +75,8 @@ Task<DgramRecvResult> Delegates::Server<SocketTag::IP>::recvFrom(std::size_t siz
         .msg_namelen = len,
         .msg_iov = &iov,
         .msg_iovlen = 1,
-        .msg_control = nullptr,
-        .msg_controllen = 0,
+        .msg_control = control.data(),
+        .msg_controllen = control.size(),
         .msg_flags = 0,
     };
 
@@ -76,7 +85,7 @@ Task<DgramRecvResult> Delegates::Server<SocketTag::IP>::recvFrom(std::size_t siz
     });
 
     data.resize(recvResult.res);
-    co_return { NetUtils::fromAddr(fromAddr, len, ConnectionType::UDP), data };
+    co_return { NetUtils::fromAddr(fromAddr, len, ConnectionType::UDP), data, NetUtils::getTimestamp(msg) };
 }
 
 template <>
@@ -120,7 +129,7 @@ ServerAddress Delegates::Server<SocketTag::BT>::startServer(const Device& server
 }
 
 template <>
-Task<AcceptResult> Delegates::Server<SocketTag::BT>::accept() {
+Task<Delegates::AcceptHandleResult<SocketTag::BT>> Delegates::Server<SocketTag::BT>::acceptHandle() {
     int sockType;
     socklen_t sockTypeLen = sizeof(sockType);
 
@@ -159,14 +168,35 @@ Task<AcceptResult> Delegates::Server<SocketTag::BT>::accept() {
     ba2str(&clientbdAddr, device.address.data());
 
     // Get device name
-    device.name.resize(1024);
-    int devID = check(hci_get_route(nullptr));
+    // This waits for a request to the remote device, so it does not run on the event loop.
+    device.name = co_await Async::offload([clientbdAddr] {
+        std::string name(1024, '\0');
+        int devID = check(hci_get_route(nullptr));
+
+        // HCI socket uses same close call as a standard socket
+        SocketHandle<SocketTag::BT> hciSock{ check(hci_open_dev(devID)) };
+
+        check(hci_read_remote_name(*hciSock, &clientbdAddr, name.size(), name.data(), 0));
+        Strings::stripNull(name);
+        return name;
+    });
+
+    co_return { device, std::move(fd) };
+}
 
-    // HCI socket uses same close call as a standard socket
-    SocketHandle<SocketTag::BT> hciSock{ check(hci_open_dev(devID)) };
+template <>
+ServerAddress Delegates::Server<SocketTag::Unix>::startServer(const Device& serverInfo) {
+    traits.type = serverInfo.type;
+    return UnixUtils::startServer(serverInfo, handle);
+}
+
+template <>
+Task<Delegates::AcceptHandleResult<SocketTag::Unix>> Delegates::Server<SocketTag::Unix>::acceptHandle() {
+    UnixUtils::Address client;
+    auto clientAddr = reinterpret_cast<sockaddr*>(&client.addr);
 
-    check(hci_read_remote_name(*hciSock, &clientbdAddr, device.name.size(), device.name.data(), 0));
-    Strings::stripNull(device.name);
+    auto acceptResult = co_await Async::run(std::bind_front(startAccept, *handle, clientAddr, std::ref(client.len)));
 
-    co_return { device, std::make_unique<IncomingSocket<SocketTag::BT>>(std::move(fd)) };
+    SocketHandle<SocketTag::Unix> fd{ acceptResult.res };
+    co_return { UnixUtils::getPeer(*fd, client, traits.type), std::move(fd) };
 }
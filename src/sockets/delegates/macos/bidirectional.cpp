@@ -17,8 +17,8 @@
 #include "os/error.hpp"
 #include "utils/task.hpp"
 
-template <>
-Task<> Delegates::Bidirectional<SocketTag::IP>::send(std::string data) {
+template <auto Tag>
+Task<> Delegates::Bidirectional<Tag>::send(std::string data) {
     co_await Async::run([this](Async::CompletionResult& result) {
         Async::submit(Async::Send{ { *handle, &result } });
     });
@@ -26,8 +26,8 @@ Task<> Delegates::Bidirectional<SocketTag::IP>::send(std::string data) {
     check(::send(*handle, data.data(), data.size(), 0));
 }
 
-template <>
-Task<RecvResult> Delegates::Bidirectional<SocketTag::IP>::recv(std::size_t size) {
+template <auto Tag>
+Task<RecvResult> Delegates::Bidirectional<Tag>::recv(std::size_t size) {
     co_await Async::run([this](Async::CompletionResult& result) {
         Async::submit(Async::Receive{ { *handle, &result } });
     });
@@ -57,3 +57,9 @@ Task<RecvResult> Delegates::Bidirectional<SocketTag::BT>::recv(std::size_t) {
     co_return readResult ? RecvResult{ true, false, *readResult, std::nullopt }
                          : RecvResult{ true, true, "", std::nullopt };
 }
+
+template Task<> Delegates::Bidirectional<SocketTag::IP>::send(std::string);
+template Task<RecvResult> Delegates::Bidirectional<SocketTag::IP>::recv(std::size_t);
+
+template Task<> Delegates::Bidirectional<SocketTag::Unix>::send(std::string);
+template Task<RecvResult> Delegates::Bidirectional<SocketTag::Unix>::recv(std::size_t);
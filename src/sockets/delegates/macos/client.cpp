@@ -12,17 +12,23 @@
 #include "net/device.hpp"
 #include "net/enums.hpp"
 #include "net/netutils.hpp"
+#include "net/unixutils.hpp"
 #include "os/async.hpp"
 #include "os/bluetooth.hpp"
 #include "os/errcheck.hpp"
 #include "os/error.hpp"
+#include "os/offload.hpp"
 
 template <>
 Task<> Delegates::Client<SocketTag::IP>::connect(Device device) {
-    auto addr = NetUtils::resolveAddr(device);
+    // Name lookups can block for a long time, so they do not run on the event loop
+    // The device is copied since the lookup keeps running if this coroutine is canceled and destroyed
+    auto resolve = [device] { return NetUtils::resolveAddr(device); };
+    auto addr = co_await Async::offload(std::move(resolve));
 
-    co_await NetUtils::loopWithAddr(addr.get(), [this](const AddrInfoType* result) -> Task<> {
+    co_await NetUtils::loopWithAddr(addr.get(), [this, type = device.type](const AddrInfoType* result) -> Task<> {
         handle.reset(check(::socket(result->ai_family, result->ai_socktype, result->ai_protocol)));
+        NetUtils::setClientOptions(*handle, handle.getOptions(), type == ConnectionType::TCP);
 
         Async::prepSocket(*handle);
 
@@ -61,3 +67,17 @@ Task<> Delegates::Client<SocketTag::BT>::connect(Device device) {
     co_await Async::run(std::bind_front(AsyncBT::submit, (*handle)->getHash(), IOType::Send),
         System::ErrorType::IOReturn);
 }
+
+template <>
+Task<> Delegates::Client<SocketTag::Unix>::connect(Device device) {
+    auto addr = UnixUtils::toAddr(device.address);
+    handle.reset(check(::socket(AF_UNIX, UnixUtils::getSocketType(device.type), 0)));
+
+    Async::prepSocket(*handle);
+
+    // Start connect
+    check(::connect(*handle, reinterpret_cast<sockaddr*>(&addr.addr), addr.len));
+    co_await Async::run([this](Async::CompletionResult& result) {
+        Async::submit(Async::Connect{ { *handle, &result } });
+    });
+}
@@ -4,29 +4,30 @@
 #include "sockets/delegates/server.hpp"
 
 #include <functional>
-#include <memory>
+#include <utility>
 
 #include <BluetoothMacOS-Swift.h>
 #include <sys/socket.h>
 
 #include "net/netutils.hpp"
+#include "net/unixutils.hpp"
 #include "os/async.hpp"
 #include "os/bluetooth.hpp"
 #include "os/errcheck.hpp"
 #include "os/error.hpp"
-#include "sockets/incomingsocket.hpp"
 #include "utils/task.hpp"
 
 template <>
 ServerAddress Delegates::Server<SocketTag::IP>::startServer(const Device& serverInfo) {
     ServerAddress result = NetUtils::startServer(serverInfo, handle);
+    acceptOptions = NetUtils::getAcceptedOptions(handle.getOptions());
 
     Async::prepSocket(*handle);
     return result;
 }
 
 template <>
-Task<AcceptResult> Delegates::Server<SocketTag::IP>::accept() {
+Task<Delegates::AcceptHandleResult<SocketTag::IP>> Delegates::Server<SocketTag::IP>::acceptHandle() {
     co_await Async::run([this](Async::CompletionResult& result) {
         Async::submit(Async::Accept{ { *handle, &result } });
     });
@@ -39,7 +40,9 @@ Task<AcceptResult> Delegates::Server<SocketTag::IP>::accept() {
     Device device = NetUtils::fromAddr(clientAddr, clientLen, ConnectionType::TCP);
 
     Async::prepSocket(*fd);
-    co_return { device, std::make_unique<IncomingSocket<SocketTag::IP>>(std::move(fd)) };
+    fd.setInheritedOptions(handle.getOptions());
+    if (acceptOptions) NetUtils::setAcceptedOptions(*fd, *acceptOptions);
+    co_return { device, std::move(fd) };
 }
 
 template <>
@@ -82,12 +85,37 @@ ServerAddress Delegates::Server<SocketTag::BT>::startServer(const Device& server
 }
 
 template <>
-Task<AcceptResult> Delegates::Server<SocketTag::BT>::accept() {
+Task<Delegates::AcceptHandleResult<SocketTag::BT>> Delegates::Server<SocketTag::BT>::acceptHandle() {
     co_await Async::run(std::bind_front(AsyncBT::submit, (*handle)->getHash(), IOType::Receive),
         System::ErrorType::IOReturn);
 
     auto [device, newHandle] = AsyncBT::getAcceptResult((*handle)->getHash());
     SocketHandle<SocketTag::BT> fd{ std::move(newHandle) };
 
-    co_return { device, std::make_unique<IncomingSocket<SocketTag::BT>>(std::move(fd)) };
+    co_return { device, std::move(fd) };
+}
+
+template <>
+ServerAddress Delegates::Server<SocketTag::Unix>::startServer(const Device& serverInfo) {
+    traits.type = serverInfo.type;
+    ServerAddress result = UnixUtils::startServer(serverInfo, handle);
+
+    Async::prepSocket(*handle);
+    return result;
+}
+
+template <>
+Task<Delegates::AcceptHandleResult<SocketTag::Unix>> Delegates::Server<SocketTag::Unix>::acceptHandle() {
+    co_await Async::run([this](Async::CompletionResult& result) {
+        Async::submit(Async::Accept{ { *handle, &result } });
+    });
+
+    UnixUtils::Address client;
+    auto clientAddr = reinterpret_cast<sockaddr*>(&client.addr);
+
+    SocketHandle<SocketTag::Unix> fd{ check(::accept(*handle, clientAddr, &client.len)) };
+    Device device = UnixUtils::getPeer(*fd, client, traits.type);
+
+    Async::prepSocket(*fd);
+    co_return { device, std::move(fd) };
 }
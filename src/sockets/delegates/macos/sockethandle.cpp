@@ -4,6 +4,7 @@
 #include "sockets/delegates/sockethandle.hpp"
 
 #include "net/enums.hpp"
+#include "net/netutils.hpp"
 #include "os/async.hpp"
 #include "os/bluetooth.hpp"
 
@@ -18,6 +19,11 @@ void Delegates::SocketHandle<SocketTag::IP>::cancelIO() {
     Async::submit(Async::Cancel{ { **this, nullptr } });
 }
 
+template <>
+void Delegates::SocketHandle<SocketTag::IP>::applyOptions() {
+    NetUtils::setOptions(handle, options);
+}
+
 template <>
 void Delegates::SocketHandle<SocketTag::BT>::closeImpl() {
     handle->close();
@@ -27,3 +33,24 @@ template <>
 void Delegates::SocketHandle<SocketTag::BT>::cancelIO() {
     AsyncBT::cancel(handle->getHash());
 }
+
+template <>
+void Delegates::SocketHandle<SocketTag::BT>::applyOptions() {
+    // Socket options are not supported on Bluetooth handles
+}
+
+template <>
+void Delegates::SocketHandle<SocketTag::Unix>::closeImpl() {
+    Async::submit(Async::Shutdown{ { **this, nullptr } });
+    Async::submit(Async::Close{ { **this, nullptr } });
+}
+
+template <>
+void Delegates::SocketHandle<SocketTag::Unix>::cancelIO() {
+    Async::submit(Async::Cancel{ { **this, nullptr } });
+}
+
+template <>
+void Delegates::SocketHandle<SocketTag::Unix>::applyOptions() {
+    // Socket options are not supported on Unix domain sockets
+}
@@ -65,6 +65,10 @@ namespace Delegates {
             handle.cancelIO();
         }
 
+        void setOptions(const SocketOptions& options) override {
+            handle.setOptions(options);
+        }
+
         Task<> connect(Device device) override;
 
         Task<> send(std::string data) override;
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -12,14 +14,23 @@
 #include "traits.hpp"
 #include "net/device.hpp"
 #include "net/enums.hpp"
+#include "sockets/incomingsocket.hpp"
 #include "utils/task.hpp"
 
 namespace Delegates {
+    // A client accepted by a server, before it is wrapped in a socket object.
+    template <auto Tag>
+    struct AcceptHandleResult {
+        Device device;
+        SocketHandle<Tag> handle;
+    };
+
     // Manages operations on server sockets.
     template <auto Tag>
-    class Server : public ServerDelegate {
+    class Server final : public ServerDelegate {
         SocketHandle<Tag>& handle;
         NO_UNIQUE_ADDRESS Traits::Server<Tag> traits;
+        std::optional<SocketOptions> acceptOptions; // Options that accepted sockets do not inherit from the listener
 
     public:
         explicit Server(SocketHandle<Tag>& handle) : handle(handle) {}
@@ -28,6 +39,9 @@ namespace Delegates {
 
         Task<AcceptResult> accept() override;
 
+        // Accepts a client connection and returns its handle without allocating a socket object.
+        Task<AcceptHandleResult<Tag>> acceptHandle();
+
         Task<DgramRecvResult> recvFrom(std::size_t size) override;
 
         Task<> sendTo(Device device, std::string data) override;
@@ -37,8 +51,14 @@ namespace Delegates {
 template <>
 ServerAddress Delegates::Server<SocketTag::BT>::startServer(const Device& serverInfo);
 
+template <auto Tag>
+Task<AcceptResult> Delegates::Server<Tag>::accept() {
+    auto [device, fd] = co_await acceptHandle();
+    co_return { device, std::make_unique<IncomingSocket<Tag>>(std::move(fd)) };
+}
+
 template <>
-Task<AcceptResult> Delegates::Server<SocketTag::BT>::accept();
+Task<Delegates::AcceptHandleResult<SocketTag::BT>> Delegates::Server<SocketTag::BT>::acceptHandle();
 
 // There are no connectionless operations on Bluetooth sockets
 
@@ -51,3 +71,15 @@ template <>
 inline Task<> Delegates::Server<SocketTag::BT>::sendTo(Device, std::string) {
     std::unreachable();
 }
+
+// Unix domain servers only use connection-oriented sockets
+
+template <>
+inline Task<DgramRecvResult> Delegates::Server<SocketTag::Unix>::recvFrom(std::size_t) {
+    std::unreachable();
+}
+
+template <>
+inline Task<> Delegates::Server<SocketTag::Unix>::sendTo(Device, std::string) {
+    std::unreachable();
+}
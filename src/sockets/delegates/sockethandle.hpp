@@ -11,15 +11,18 @@
 namespace Delegates {
     // Manages close operations on sockets.
     template <auto Tag>
-    class SocketHandle : public HandleDelegate {
+    class SocketHandle final : public HandleDelegate {
         using Handle = Traits::SocketHandleType<Tag>;
         static constexpr auto invalidHandle = Traits::invalidSocketHandle<Tag>();
 
         Handle handle;
         bool closed = false;
+        SocketOptions options;
 
         void closeImpl();
 
+        void applyOptions();
+
     public:
         SocketHandle() : SocketHandle(invalidHandle) {}
 
@@ -33,13 +36,14 @@ namespace Delegates {
         SocketHandle(const SocketHandle&) = delete;
 
         // Constructs an object and transfers ownership from another object.
-        SocketHandle(SocketHandle&& other) noexcept : handle(other.release()) {}
+        SocketHandle(SocketHandle&& other) noexcept : handle(other.release()), options(other.options) {}
 
         SocketHandle& operator=(const SocketHandle&) = delete;
 
         // Transfers ownership from another object.
         SocketHandle& operator=(SocketHandle&& other) noexcept {
             reset(other.release());
+            options = other.options;
             return *this;
         }
 
@@ -56,6 +60,21 @@ namespace Delegates {
 
         void cancelIO() override;
 
+        void setOptions(const SocketOptions& newOptions) override {
+            options = newOptions;
+            if (isValid()) applyOptions();
+        }
+
+        // Records options that the socket already has (e.g. ones inherited from a listener) without applying them.
+        void setInheritedOptions(const SocketOptions& inherited) {
+            options = inherited;
+        }
+
+        // Gets the options to apply when the socket is created.
+        const SocketOptions& getOptions() const {
+            return options;
+        }
+
         // Closes the current handle and acquires a new one.
         void reset(Handle other = invalidHandle) noexcept {
             close();
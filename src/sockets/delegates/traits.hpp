@@ -36,6 +36,12 @@ namespace Traits {
         using HandleType = std::optional<BluetoothMacOS::BTHandle>;
         static constexpr auto invalidHandle = std::nullopt;
     };
+
+    template <>
+    struct SocketHandle<SocketTag::Unix> {
+        using HandleType = int;
+        static constexpr auto invalidHandle = -1;
+    };
 #elif OS_LINUX
     template <auto Tag>
     struct SocketHandle {
@@ -62,4 +68,9 @@ namespace Traits {
     struct Server<SocketTag::IP> {
         IPType ip;
     };
+
+    template <>
+    struct Server<SocketTag::Unix> {
+        ConnectionType type;
+    };
 }
@@ -3,37 +3,78 @@
 
 #include "sockets/delegates/bidirectional.hpp"
 
+#include <expected>
 #include <string>
+#include <utility>
 
 #include "net/enums.hpp"
 #include "os/async.hpp"
+#include "os/error.hpp"
 #include "utils/task.hpp"
 
 template <auto Tag>
-Task<> Delegates::Bidirectional<Tag>::send(std::string data) {
-    co_await Async::run([this, &data](Async::CompletionResult& result) {
+template <bool Throws>
+auto Delegates::Bidirectional<Tag>::sendData(std::string data) -> Task<IOResult<Throws, void>> {
+    auto sendResult = co_await Async::tryRun([this, &data](Async::CompletionResult& result) {
         Async::submit(Async::Send{ { *handle, &result }, data });
     });
+
+    if (!sendResult) {
+        if constexpr (Throws) throw System::SystemError{ sendResult.error() };
+        else co_return std::unexpected{ sendResult.error() };
+    }
+
+    if constexpr (!Throws) co_return {};
 }
 
 template <auto Tag>
-Task<RecvResult> Delegates::Bidirectional<Tag>::recv(std::size_t size) {
+template <bool Throws>
+auto Delegates::Bidirectional<Tag>::recvData(std::size_t size) -> Task<IOResult<Throws, RecvResult>> {
     std::string data(size, 0);
 
-    auto recvResult = co_await Async::run([this, &data](Async::CompletionResult& result) {
+    auto recvResult = co_await Async::tryRun([this, &data](Async::CompletionResult& result) {
         Async::submit(Async::Receive{ { *handle, &result }, data });
     });
 
+    if (!recvResult) {
+        if constexpr (Throws) throw System::SystemError{ recvResult.error() };
+        else co_return std::unexpected{ recvResult.error() };
+    }
+
     // Check for disconnects
-    if (recvResult.res == 0) co_return { true, true, "", std::nullopt };
+    if (recvResult->res == 0) co_return RecvResult{ true, true, "", std::nullopt };
 
     // Resize string to received size
-    data.resize(recvResult.res);
-    co_return { true, false, data, std::nullopt };
+    data.resize(recvResult->res);
+    co_return RecvResult{ true, false, data, std::nullopt };
+}
+
+template <auto Tag>
+Task<> Delegates::Bidirectional<Tag>::send(std::string data) {
+    return sendData<true>(std::move(data));
+}
+
+template <auto Tag>
+Task<System::Expected<void>> Delegates::Bidirectional<Tag>::trySend(std::string data) {
+    return sendData<false>(std::move(data));
+}
+
+template <auto Tag>
+Task<RecvResult> Delegates::Bidirectional<Tag>::recv(std::size_t size) {
+    return recvData<true>(size);
+}
+
+template <auto Tag>
+Task<System::Expected<RecvResult>> Delegates::Bidirectional<Tag>::tryRecv(std::size_t size) {
+    return recvData<false>(size);
 }
 
 template Task<> Delegates::Bidirectional<SocketTag::IP>::send(std::string);
 template Task<RecvResult> Delegates::Bidirectional<SocketTag::IP>::recv(std::size_t);
+template Task<System::Expected<void>> Delegates::Bidirectional<SocketTag::IP>::trySend(std::string);
+template Task<System::Expected<RecvResult>> Delegates::Bidirectional<SocketTag::IP>::tryRecv(std::size_t);
 
 template Task<> Delegates::Bidirectional<SocketTag::BT>::send(std::string);
 template Task<RecvResult> Delegates::Bidirectional<SocketTag::BT>::recv(std::size_t);
+template Task<System::Expected<void>> Delegates::Bidirectional<SocketTag::BT>::trySend(std::string);
+template Task<System::Expected<RecvResult>> Delegates::Bidirectional<SocketTag::BT>::tryRecv(std::size_t);
@@ -15,6 +15,7 @@
 #include "net/netutils.hpp"
 #include "os/async.hpp"
 #include "os/errcheck.hpp"
+#include "os/offload.hpp"
 #include "utils/strings.hpp"
 
 void startConnect(SOCKET s, sockaddr* addr, std::size_t len, Async::CompletionResult& result) {
@@ -40,10 +41,14 @@ void finalizeConnect(SOCKET s) {
 
 template <>
 Task<> Delegates::Client<SocketTag::IP>::connect(Device device) {
-    auto addr = NetUtils::resolveAddr(device);
+    // Name lookups can block for a long time, so they do not run on the event loop
+    // The device is copied since the lookup keeps running if this coroutine is canceled and destroyed
+    auto resolve = [device] { return NetUtils::resolveAddr(device); };
+    auto addr = co_await Async::offload(std::move(resolve));
 
     co_await NetUtils::loopWithAddr(addr.get(), [this, type = device.type](const AddrInfoType* result) -> Task<> {
         handle.reset(check(socket(result->ai_family, result->ai_socktype, result->ai_protocol)));
+        NetUtils::setClientOptions(*handle, handle.getOptions(), type == ConnectionType::TCP);
 
         // Add the socket to the async queue
         Async::add(*handle);
@@ -4,7 +4,6 @@
 #include "sockets/delegates/server.hpp"
 
 #include <cstdint>
-#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -18,7 +17,6 @@
 #include "net/netutils.hpp"
 #include "os/async.hpp"
 #include "os/errcheck.hpp"
-#include "sockets/incomingsocket.hpp"
 #include "utils/strings.hpp"
 #include "utils/task.hpp"
 
@@ -63,12 +61,13 @@ ServerAddress Delegates::Server<SocketTag::IP>::startServer(const Device& server
 
     Async::add(*handle);
     traits.ip = result.ipType;
+    acceptOptions = NetUtils::getAcceptedOptions(handle.getOptions());
 
     return result;
 }
 
 template <>
-Task<AcceptResult> Delegates::Server<SocketTag::IP>::accept() {
+Task<Delegates::AcceptHandleResult<SocketTag::IP>> Delegates::Server<SocketTag::IP>::acceptHandle() {
     // Socket which is associated to the client upon accept
     int af = traits.ip == IPType::IPv4 ? AF_INET : AF_INET6;
     SocketHandle<SocketTag::IP> fd{ check(socket(af, SOCK_STREAM, 0)) };
@@ -76,8 +75,12 @@ Task<AcceptResult> Delegates::Server<SocketTag::IP>::accept() {
     std::vector<BYTE> buf(addrSize * 2);
     auto [remoteAddrPtr, remoteAddrLen] = co_await startAccept(*handle, buf, *fd);
 
+    // Options are inherited once SO_UPDATE_ACCEPT_CONTEXT is set in startAccept()
+    fd.setInheritedOptions(handle.getOptions());
+    if (acceptOptions) NetUtils::setAcceptedOptions(*fd, *acceptOptions);
+
     Device device = NetUtils::fromAddr(remoteAddrPtr, remoteAddrLen, ConnectionType::TCP);
-    co_return { device, std::make_unique<IncomingSocket<SocketTag::IP>>(std::move(fd)) };
+    co_return { device, std::move(fd) };
 }
 
 template <>
@@ -127,7 +130,7 @@ ServerAddress Delegates::Server<SocketTag::BT>::startServer(const Device& server
 }
 
 template <>
-Task<AcceptResult> Delegates::Server<SocketTag::BT>::accept() {
+Task<Delegates::AcceptHandleResult<SocketTag::BT>> Delegates::Server<SocketTag::BT>::acceptHandle() {
     SocketHandle<SocketTag::BT> fd{ check(socket(AF_BTH, SOCK_STREAM, BTHPROTO_RFCOMM)) };
 
     std::vector<BYTE> buf(addrSize * 2);
@@ -151,5 +154,5 @@ Task<AcceptResult> Delegates::Server<SocketTag::BT>::accept() {
 
     Device device{ ConnectionType::RFCOMM, Strings::fromSys(deviceInfo.szName), clientAddr,
         static_cast<std::uint16_t>(clientPtr->port) };
-    co_return { device, std::make_unique<IncomingSocket<SocketTag::BT>>(std::move(fd)) };
+    co_return { device, std::move(fd) };
 }
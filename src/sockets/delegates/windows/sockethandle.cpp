@@ -5,6 +5,7 @@
 
 #include "sockets/delegates/sockethandle.hpp"
 
+#include "net/netutils.hpp"
 #include "os/async.hpp"
 
 template <auto Tag>
@@ -18,8 +19,16 @@ void Delegates::SocketHandle<Tag>::cancelIO() {
     Async::submit(Async::Cancel{ { **this, nullptr } });
 }
 
+template <auto Tag>
+void Delegates::SocketHandle<Tag>::applyOptions() {
+    // Socket options are only supported on Internet Protocol sockets
+    if constexpr (Tag == SocketTag::IP) NetUtils::setOptions(handle, options);
+}
+
 template void Delegates::SocketHandle<SocketTag::IP>::closeImpl();
 template void Delegates::SocketHandle<SocketTag::IP>::cancelIO();
+template void Delegates::SocketHandle<SocketTag::IP>::applyOptions();
 
 template void Delegates::SocketHandle<SocketTag::BT>::closeImpl();
 template void Delegates::SocketHandle<SocketTag::BT>::cancelIO();
+template void Delegates::SocketHandle<SocketTag::BT>::applyOptions();
@@ -3,10 +3,15 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "delegates/delegates.hpp"
 #include "net/device.hpp"
+#include "os/error.hpp"
+#include "os/file.hpp"
+#include "os/generator.hpp"
 #include "utils/task.hpp"
 
 // Socket of any type.
@@ -36,6 +41,10 @@ public:
         handle->cancelIO();
     }
 
+    void setOptions(const SocketOptions& options) const {
+        handle->setOptions(options);
+    }
+
     Task<> send(std::string_view data) const {
         return io->send(std::string{ data });
     }
@@ -44,6 +53,26 @@ public:
         return io->recv(size);
     }
 
+    Task<System::Expected<void>> trySend(std::string_view data) const {
+        return io->trySend(std::string{ data });
+    }
+
+    Task<System::Expected<RecvResult>> tryRecv(std::size_t size) const {
+        return io->tryRecv(size);
+    }
+
+    Async::Generator<System::Expected<RecvResult>> recvStream(std::size_t size) const {
+        return Delegates::recvStream(*io, size);
+    }
+
+    Task<std::uint64_t> sendTimestamped(std::string_view data) const {
+        return io->sendTimestamped(std::string{ data });
+    }
+
+    Task<std::size_t> sendFile(File& file, std::int64_t offset, std::size_t size) const {
+        return io->sendFile(file, offset, size);
+    }
+
     Task<> connect(const Device& device) const {
         return client->connect(device);
     }
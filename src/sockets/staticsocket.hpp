@@ -0,0 +1,172 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "delegates/bidirectional.hpp"
+#include "delegates/client.hpp"
+#include "delegates/delegates.hpp"
+#include "delegates/server.hpp"
+#include "delegates/sockethandle.hpp"
+#include "net/device.hpp"
+#include "os/error.hpp"
+#include "os/generator.hpp"
+#include "utils/task.hpp"
+
+namespace Delegates {
+    // Placeholder for a delegate that a static socket does not have.
+    template <auto Tag>
+    struct None {
+        explicit None(SocketHandle<Tag>&) {}
+    };
+
+    // Type that performs I/O operations.
+    template <class T>
+    concept IOType = requires (T& t, std::string data, std::size_t size) {
+        { t.send(std::move(data)) } -> std::same_as<Task<>>;
+        { t.recv(size) } -> std::same_as<Task<RecvResult>>;
+        { t.trySend(std::move(data)) } -> std::same_as<Task<System::Expected<void>>>;
+        { t.tryRecv(size) } -> std::same_as<Task<System::Expected<RecvResult>>>;
+    };
+
+    // Type that performs client operations.
+    template <class T>
+    concept ClientType = requires (T& t, Device device) {
+        { t.connect(std::move(device)) } -> std::same_as<Task<>>;
+    };
+
+    // Type that performs server operations.
+    template <class T, auto Tag>
+    concept ServerType = requires (T& t, const Device& serverInfo) {
+        { t.startServer(serverInfo) } -> std::same_as<ServerAddress>;
+        { t.acceptHandle() } -> std::same_as<Task<AcceptHandleResult<Tag>>>;
+    };
+}
+
+// Socket with delegates chosen at compile time.
+// Unlike Socket, calls are dispatched statically and there are no no-op delegates for unused operations. This is
+// intended for code on the I/O hot path (e.g. worker loops and benchmarks); the GUI keeps using Socket since it needs
+// to hold different kinds of sockets through one type.
+template <auto Tag, template <auto> class IO = Delegates::None, template <auto> class Client = Delegates::None,
+    template <auto> class Server = Delegates::None>
+requires (std::same_as<IO<Tag>, Delegates::None<Tag>> || Delegates::IOType<IO<Tag>>)
+    && (std::same_as<Client<Tag>, Delegates::None<Tag>> || Delegates::ClientType<Client<Tag>>)
+    && (std::same_as<Server<Tag>, Delegates::None<Tag>> || Delegates::ServerType<Server<Tag>, Tag>)
+class StaticSocket {
+    static constexpr bool hasIO = !std::same_as<IO<Tag>, Delegates::None<Tag>>;
+    static constexpr bool hasClient = !std::same_as<Client<Tag>, Delegates::None<Tag>>;
+    static constexpr bool hasServer = !std::same_as<Server<Tag>, Delegates::None<Tag>>;
+
+    Delegates::SocketHandle<Tag> handle;
+    NO_UNIQUE_ADDRESS IO<Tag> io{ handle };
+    NO_UNIQUE_ADDRESS Client<Tag> client{ handle };
+    NO_UNIQUE_ADDRESS Server<Tag> server{ handle };
+
+public:
+    StaticSocket() = default;
+
+    // Takes ownership of an existing handle (e.g. one from acceptHandle()).
+    explicit StaticSocket(Delegates::SocketHandle<Tag>&& handle) : handle(std::move(handle)) {}
+
+    // The delegates hold references to the handle, so the socket cannot be copied or moved.
+    StaticSocket(const StaticSocket&) = delete;
+    StaticSocket& operator=(const StaticSocket&) = delete;
+
+    void close() {
+        handle.close();
+    }
+
+    bool isValid() {
+        return handle.isValid();
+    }
+
+    void cancelIO() {
+        handle.cancelIO();
+    }
+
+    void setOptions(const SocketOptions& options) {
+        handle.setOptions(options);
+    }
+
+    // Gets the underlying handle, for operations that are not part of the delegates (e.g. splicing between sockets).
+    const Delegates::SocketHandle<Tag>& getHandle() const {
+        return handle;
+    }
+
+    Task<> send(std::string_view data)
+    requires hasIO
+    {
+        return io.send(std::string{ data });
+    }
+
+    Task<RecvResult> recv(std::size_t size)
+    requires hasIO
+    {
+        return io.recv(size);
+    }
+
+    Task<System::Expected<void>> trySend(std::string_view data)
+    requires hasIO
+    {
+        return io.trySend(std::string{ data });
+    }
+
+    Task<System::Expected<RecvResult>> tryRecv(std::size_t size)
+    requires hasIO
+    {
+        return io.tryRecv(size);
+    }
+
+    Async::Generator<System::Expected<RecvResult>> recvStream(std::size_t size)
+    requires hasIO
+    {
+        return Delegates::recvStream(io, size);
+    }
+
+    Task<> connect(const Device& device)
+    requires hasClient
+    {
+        return client.connect(device);
+    }
+
+    ServerAddress startServer(const Device& serverInfo)
+    requires hasServer
+    {
+        return server.startServer(serverInfo);
+    }
+
+    Task<Delegates::AcceptHandleResult<Tag>> accept()
+    requires hasServer
+    {
+        return server.acceptHandle();
+    }
+
+    Task<DgramRecvResult> recvFrom(std::size_t size)
+    requires hasServer
+    {
+        return server.recvFrom(size);
+    }
+
+    Task<> sendTo(const Device& device, std::string_view data)
+    requires hasServer
+    {
+        return server.sendTo(device, std::string{ data });
+    }
+};
+
+// Statically dispatched counterparts of ClientSocket, ServerSocket, and IncomingSocket.
+
+template <auto Tag>
+using StaticClientSocket = StaticSocket<Tag, Delegates::Bidirectional, Delegates::Client>;
+
+template <auto Tag>
+using StaticServerSocket = StaticSocket<Tag, Delegates::None, Delegates::None, Delegates::Server>;
+
+template <auto Tag>
+using StaticIncomingSocket = StaticSocket<Tag, Delegates::Bidirectional>;
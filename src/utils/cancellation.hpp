@@ -0,0 +1,142 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+class CancelCallback;
+
+// State shared between a cancellation source and its tokens.
+// Cancellation is not synchronized, so a source must be canceled on the thread that runs the work it cancels.
+class CancelState {
+    CancelCallback* head = nullptr; // Callbacks waiting for cancellation, as a doubly linked list
+    bool canceled = false;
+
+public:
+    bool isCanceled() const {
+        return canceled;
+    }
+
+    // Adds a callback to run on cancellation.
+    void add(CancelCallback& callback);
+
+    // Removes a callback that has not run yet.
+    void remove(CancelCallback& callback);
+
+    // Marks the state as canceled and runs all callbacks, each one only once.
+    void cancel();
+};
+
+// Handle to the state of a cancellation source, which is checked and passed down to the work that can be canceled.
+class CancelToken {
+    friend class CancelCallback;
+    friend class CancelSource;
+
+    std::shared_ptr<CancelState> state;
+
+    explicit CancelToken(std::shared_ptr<CancelState> state) : state(std::move(state)) {}
+
+public:
+    // Constructs a token that can never be canceled.
+    CancelToken() = default;
+
+    bool isCanceled() const {
+        return state && state->isCanceled();
+    }
+
+    // Checks if the token comes from a source, so it can be canceled.
+    explicit operator bool() const {
+        return static_cast<bool>(state);
+    }
+};
+
+// Requests cancellation of the work that holds its tokens.
+class CancelSource {
+    std::shared_ptr<CancelState> state = std::make_shared<CancelState>();
+
+public:
+    CancelToken getToken() const {
+        return CancelToken{ state };
+    }
+
+    bool isCanceled() const {
+        return state->isCanceled();
+    }
+
+    void cancel() {
+        state->cancel();
+    }
+};
+
+// Function that runs when a cancellation source is canceled.
+// Callbacks are nodes of a list in the source's state, so attaching and detaching them does not allocate.
+class CancelCallback {
+    friend class CancelState;
+
+    CancelState* state = nullptr; // The state this callback is attached to (kept alive by the token's holder)
+    CancelCallback* prev = nullptr;
+    CancelCallback* next = nullptr;
+
+protected:
+    ~CancelCallback() {
+        detach();
+    }
+
+    // Called once when the source is canceled, after the callback is detached.
+    virtual void onCancel() = 0;
+
+public:
+    CancelCallback() = default;
+
+    CancelCallback(const CancelCallback&) = delete;
+
+    CancelCallback& operator=(const CancelCallback&) = delete;
+
+    // Runs the callback when the token's source is canceled, or right away if it already was.
+    void attach(const CancelToken& token) {
+        detach();
+        if (!token) return;
+
+        if (token.isCanceled()) {
+            onCancel();
+            return;
+        }
+
+        state = token.state.get();
+        state->add(*this);
+    }
+
+    // Stops the callback from running.
+    void detach() {
+        if (state) state->remove(*this);
+    }
+};
+
+inline void CancelState::add(CancelCallback& callback) {
+    callback.next = head;
+    if (head) head->prev = &callback;
+    head = &callback;
+}
+
+inline void CancelState::remove(CancelCallback& callback) {
+    if (callback.prev) callback.prev->next = callback.next;
+    else head = callback.next;
+
+    if (callback.next) callback.next->prev = callback.prev;
+    callback.state = nullptr;
+    callback.prev = callback.next = nullptr;
+}
+
+inline void CancelState::cancel() {
+    if (canceled) return;
+    canceled = true;
+
+    // Callbacks can detach others when they run, so each one is removed before it is called
+    while (head) {
+        CancelCallback& callback = *head;
+        remove(callback);
+        callback.onCancel();
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "framepool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Number of size classes
+constexpr std::size_t numClasses = FramePool::maxPooledSize / FramePool::granularity;
+
+// Maximum number of blocks kept in each freelist, extra blocks are returned to the global allocator
+constexpr std::size_t maxFreeBlocks = 256;
+
+// Block in a freelist. The memory of a free block stores the link to the next one.
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Freelists of the current thread.
+class Freelists {
+    struct List {
+        FreeBlock* head = nullptr;
+        std::size_t size = 0;
+    };
+
+    std::array<List, numClasses> lists;
+    bool active = true; // Frames freed during thread exit after the freelists are emptied bypass them
+
+public:
+    Freelists() = default;
+
+    Freelists(const Freelists&) = delete;
+
+    Freelists& operator=(const Freelists&) = delete;
+
+    // Returns all free blocks to the global allocator when the thread exits.
+    ~Freelists() {
+        active = false;
+        for (auto& list : lists) {
+            while (list.head) ::operator delete(std::exchange(list.head, list.head->next));
+        }
+    }
+
+    // Takes a block from a size class, or allocates a new one if the freelist is empty.
+    void* pop(std::size_t sizeClass) {
+        auto& list = lists[sizeClass];
+        if (!list.head) return ::operator new((sizeClass + 1) * FramePool::granularity);
+
+        list.size--;
+        return std::exchange(list.head, list.head->next);
+    }
+
+    // Returns a block to a size class.
+    void push(void* p, std::size_t sizeClass) noexcept {
+        auto& list = lists[sizeClass];
+        if (!active || list.size == maxFreeBlocks) {
+            ::operator delete(p);
+            return;
+        }
+
+        list.size++;
+        list.head = ::new (p) FreeBlock{ list.head };
+    }
+};
+
+thread_local Freelists freelists;
+
+// Gets the size class that fits a block of the given size.
+constexpr std::size_t getSizeClass(std::size_t size) {
+    return (size - 1) / FramePool::granularity;
+}
+
+void* FramePool::allocate(std::size_t size) {
+    if (size == 0 || size > maxPooledSize) return ::operator new(size);
+    return freelists.pop(getSizeClass(size));
+}
+
+void FramePool::deallocate(void* p, std::size_t size) noexcept {
+    if (size == 0 || size > maxPooledSize) ::operator delete(p);
+    else freelists.push(p, getSizeClass(size));
+}
@@ -0,0 +1,97 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Allocates coroutine frames from per-thread freelists, one for each size class, or with custom allocators.
+// Frames that are too large for any size class are allocated with the global operator new. A frame may be freed on a
+// different thread than the one that allocated it, in which case its block joins the freelist of the freeing thread.
+namespace FramePool {
+    // Step between size classes in bytes
+    inline constexpr std::size_t granularity = 64;
+
+    // Size of the largest size class in bytes
+    inline constexpr std::size_t maxPooledSize = 2048;
+
+    // Allocates a block of at least the given size.
+    void* allocate(std::size_t size);
+
+    // Frees a block, given the size it was allocated with.
+    void deallocate(void* p, std::size_t size) noexcept;
+
+    // Function that frees a frame allocated with a custom allocator.
+    using Deleter = void (*)(void* frame, std::size_t size) noexcept;
+
+    // Unit of memory requested from custom allocators, aligned for any coroutine frame.
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) Block {
+        std::byte data[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+    };
+
+    // Rounds a size up to a multiple of an alignment.
+    constexpr std::size_t alignUp(std::size_t size, std::size_t alignment) {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // Gets the offset of the deleter stored after a frame. It is null if the frame came from the pool.
+    constexpr std::size_t deleterOffset(std::size_t size) {
+        return alignUp(size, alignof(Deleter));
+    }
+
+    // Allocates a coroutine frame from the pool.
+    inline void* allocateFrame(std::size_t size) {
+        std::size_t offset = deleterOffset(size);
+        auto frame = static_cast<std::byte*>(allocate(offset + sizeof(Deleter)));
+        ::new (frame + offset) Deleter{ nullptr };
+        return frame;
+    }
+
+    // Gets the offset of the allocator stored after a frame and the number of blocks allocated for it.
+    // Layout: [frame] [deleter] [allocator]
+    template <class BlockAlloc>
+    constexpr std::pair<std::size_t, std::size_t> customLayout(std::size_t size) {
+        std::size_t allocOffset = alignUp(deleterOffset(size) + sizeof(Deleter), alignof(BlockAlloc));
+        std::size_t numBlocks = alignUp(allocOffset + sizeof(BlockAlloc), sizeof(Block)) / sizeof(Block);
+        return { allocOffset, numBlocks };
+    }
+
+    // Frees a coroutine frame allocated with a custom allocator.
+    template <class BlockAlloc>
+    void deallocateCustom(void* frame, std::size_t size) noexcept {
+        auto [allocOffset, numBlocks] = customLayout<BlockAlloc>(size);
+        auto storedAlloc = std::launder(reinterpret_cast<BlockAlloc*>(static_cast<std::byte*>(frame) + allocOffset));
+
+        // Move the allocator out of the memory it is about to free
+        BlockAlloc blockAlloc{ std::move(*storedAlloc) };
+        storedAlloc->~BlockAlloc();
+        std::allocator_traits<BlockAlloc>::deallocate(blockAlloc, static_cast<Block*>(frame), numBlocks);
+    }
+
+    // Allocates a coroutine frame with a custom allocator, storing a copy of the allocator after the frame to free it.
+    template <class Alloc>
+    void* allocateFrame(std::size_t size, const Alloc& alloc) {
+        using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+        static_assert(alignof(BlockAlloc) <= alignof(Block), "Allocator is over-aligned");
+
+        auto [allocOffset, numBlocks] = customLayout<BlockAlloc>(size);
+        BlockAlloc blockAlloc{ alloc };
+        Block* blocks = std::allocator_traits<BlockAlloc>::allocate(blockAlloc, numBlocks);
+        auto frame = reinterpret_cast<std::byte*>(blocks);
+        ::new (frame + allocOffset) BlockAlloc{ std::move(blockAlloc) };
+        ::new (frame + deleterOffset(size)) Deleter{ &deallocateCustom<BlockAlloc> };
+        return frame;
+    }
+
+    // Frees a coroutine frame allocated by either overload of allocateFrame.
+    inline void deallocateFrame(void* frame, std::size_t size) noexcept {
+        std::size_t offset = deleterOffset(size);
+        Deleter deleter = *std::launder(reinterpret_cast<Deleter*>(static_cast<std::byte*>(frame) + offset));
+
+        if (deleter) deleter(frame, size);
+        else deallocate(frame, offset + sizeof(Deleter));
+    }
+}
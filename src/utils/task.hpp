@@ -3,15 +3,74 @@
 
 #pragma once
 
+#include <atomic>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
+#include <memory>
+#include <optional>
 #include <type_traits>
 #include <utility>
 
-// An asynchronous coroutine's return object.
+#include "cancellation.hpp"
+#include "framepool.hpp"
+
+// Links between tasks that await each other, so a cancellation token can reach the operation at the bottom of a chain
+// of tasks. This is shared by all task types so awaiters can use it without knowing the result type.
+struct TaskPromiseBase {
+    // In the case of another coroutine calling this one, keep track of the caller. This allows us to resume the
+    // caller when this one exits.
+    std::coroutine_handle<> continuation;
+
+    TaskPromiseBase* parent = nullptr; // The task awaiting this one
+    TaskPromiseBase* awaitedTask = nullptr; // The task this one is awaiting
+    CancelCallback* pendingOperation = nullptr; // The cancelable operation this one is awaiting
+    CancelToken cancelToken; // Token passed down from the closest withCancellation call
+    bool cancelBoundary = false; // If this is the coroutine created by withCancellation, which keeps its own token
+    bool stopped = false; // If this task was canceled, in which case it is destroyed without being resumed
+
+    // Records the coroutine awaiting this one. If that coroutine is also a task, the two are linked and its
+    // cancellation token is passed down.
+    template <class Promise>
+    void setContinuation(std::coroutine_handle<Promise> current) {
+        continuation = current;
+        if constexpr (std::is_base_of_v<TaskPromiseBase, Promise>) {
+            auto& awaiter = current.promise();
+            parent = &awaiter;
+            awaiter.awaitedTask = this;
+            if (awaiter.cancelToken) setCancelToken(awaiter.cancelToken);
+        }
+    }
+
+    // Passes a token down to this task and the tasks and operation it is awaiting.
+    void setCancelToken(const CancelToken& token) {
+        for (TaskPromiseBase* p = this; p && !p->cancelBoundary; p = p->awaitedTask) {
+            p->cancelToken = token;
+            if (p->pendingOperation) p->pendingOperation->attach(token);
+        }
+    }
+
+    // Marks this task and the tasks awaiting it as stopped, up to the coroutine created by withCancellation.
+    // Returns the handle of that coroutine, which is resumed to end the stopped tasks.
+    std::coroutine_handle<> stop() {
+        TaskPromiseBase* p = this;
+        for (; p->parent && !p->parent->cancelBoundary; p = p->parent) p->stopped = true;
+
+        p->stopped = true;
+        return p->parent ? p->continuation : std::noop_coroutine();
+    }
+};
+
+// An asynchronous coroutine's return object, which owns the coroutine frame.
+// If the task is destroyed while its coroutine is still running, the coroutine is detached and its frame is destroyed
+// when it completes.
 // T: the datatype of the value(s) produced by the coroutine
-template <class T = void>
+// Lazy: if the coroutine starts when it is first awaited, instead of immediately when it is called
+template <class T = void, bool Lazy = false>
 class Task {
+    template <class, bool>
+    friend struct StoppableAwaiter;
+
     // If this template type is void-returning
     static constexpr bool isVoid = std::is_void_v<T>;
 
@@ -34,7 +93,7 @@ class Task {
     // The promise object containing the coroutine's information (returned value, exceptions).
     // This class inherits from either the "void" base or the "value" base depending on if T is void. This inheritance
     // will give the class the appropriate return function for each template instantiation.
-    struct PromiseType : std::conditional_t<isVoid, PromiseTypeVoid, PromiseTypeValue<T>> {
+    struct PromiseType : TaskPromiseBase, std::conditional_t<isVoid, PromiseTypeVoid, PromiseTypeValue<T>> {
         struct FinalSuspendAwaiter {
             [[nodiscard]] bool await_ready() const noexcept {
                 return false;
@@ -43,6 +102,13 @@ class Task {
             std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> current) const noexcept {
                 // Get the caller coroutine's handle
                 auto promiseContinuation = current.promise().continuation;
+                if (auto parent = current.promise().parent) parent->awaitedTask = nullptr;
+
+                // If the task object was already released, nothing else refers to the frame
+                if (current.promise().released.exchange(true, std::memory_order_acq_rel)) {
+                    current.destroy();
+                    return std::noop_coroutine();
+                }
 
                 // Return the handle, or a no-op handle if there is no caller coroutine
                 // Returning the caller's handle allows it to be resumed.
@@ -52,21 +118,47 @@ class Task {
             void await_resume() const noexcept {}
         };
 
-        // In the case of another coroutine calling this one, keep track of the caller. This allows us to resume the
-        // caller when this one exits.
-        std::coroutine_handle<> continuation;
-
         std::exception_ptr exception; // Any exception that was thrown in the coroutine
 
+        // Set by whichever of the task object and the completed coroutine lets go of the frame first, so the other one
+        // destroys it. This is atomic since a coroutine can complete on a different thread than its task object.
+        std::atomic_bool released = false;
+
+        bool started = !Lazy; // If the coroutine has left its initial suspension point
+
+        // Allocates the coroutine frame from the freelists of the current thread.
+        static void* operator new(std::size_t size) {
+            return FramePool::allocateFrame(size);
+        }
+
+        // Allocates the coroutine frame with an allocator passed after std::allocator_arg as the first arguments of a
+        // coroutine function.
+        template <class Alloc, class... Args>
+        static void* operator new(std::size_t size, std::allocator_arg_t, const Alloc& alloc, const Args&...) {
+            return FramePool::allocateFrame(size, alloc);
+        }
+
+        // Allocates the coroutine frame with an allocator passed after std::allocator_arg in a member coroutine.
+        template <class Self, class Alloc, class... Args>
+        static void* operator new(std::size_t size, const Self&, std::allocator_arg_t, const Alloc& alloc,
+            const Args&...) {
+            return FramePool::allocateFrame(size, alloc);
+        }
+
+        static void operator delete(void* p, std::size_t size) noexcept {
+            FramePool::deallocateFrame(p, size);
+        }
+
         // Called first when a coroutine is entered. This specifies the Task object returned from a coroutine function.
         Task get_return_object() noexcept {
             return Task{ *this };
         }
 
         // Called second when a coroutine is entered. This dictates how the coroutine starts.
-        // Returning suspend_never starts the coroutine immediately.
-        [[nodiscard]] std::suspend_never initial_suspend() const noexcept {
-            return {};
+        // Eager tasks start immediately, lazy tasks are suspended until they are awaited.
+        [[nodiscard]] auto initial_suspend() const noexcept {
+            if constexpr (Lazy) return std::suspend_always{};
+            else return std::suspend_never{};
         }
 
         // Handles any exceptions thrown in a coroutine.
@@ -86,10 +178,52 @@ class Task {
     // Constructs a task object from a coroutine promise object.
     explicit Task(PromiseType& promiseType) : handle(std::coroutine_handle<PromiseType>::from_promise(promiseType)) {}
 
+    // Gives up ownership of the coroutine frame.
+    void release() noexcept {
+        if (!handle) return;
+
+        // Lazy tasks that never started and stopped tasks cannot complete, so their frames are destroyed here
+        auto& promise = handle.promise();
+        if (!promise.started || promise.stopped || promise.released.exchange(true, std::memory_order_acq_rel))
+            handle.destroy();
+        handle = nullptr;
+    }
+
 public:
     // Type alias for the promise object for use by the compiler.
     using promise_type = PromiseType;
 
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            release();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+
+    Task& operator=(const Task&) = delete;
+
+    // Destroys the coroutine frame if the coroutine has completed, otherwise detaches it.
+    ~Task() {
+        release();
+    }
+
+    // Lets the coroutine run to completion without an owner, starting it first if it is lazy.
+    // Exceptions thrown from the coroutine are discarded.
+    void detach() && {
+        if (!handle) return;
+
+        if (auto& promise = handle.promise(); !promise.started) {
+            promise.started = true;
+            handle.resume();
+        }
+        release();
+    }
+
     // The three await methods below allow us to co_await a task.
 
     // Determines whether the coroutine needs to be suspended.
@@ -101,10 +235,17 @@ public:
     }
 
     // Keeps track of the current coroutine to resume on suspend.
-    // Called when the coroutine is suspended.
-    void await_suspend(std::coroutine_handle<> current) const noexcept {
+    // Called when the coroutine is suspended. A lazy task is started here by transferring control to it.
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> current) const {
         // Keep track of the current coroutine so it can be resumed in final_suspend
-        handle.promise().continuation = current;
+        auto& promise = handle.promise();
+        promise.setContinuation(current);
+
+        if (promise.started) return std::noop_coroutine();
+
+        promise.started = true;
+        return handle;
     }
 
     // Returns the result of the entire co_await expression (the value the coroutine produced).
@@ -117,3 +258,74 @@ public:
         if constexpr (!isVoid) return std::move(handle.promise().data);
     }
 };
+
+// A task that starts when it is first awaited, or when it is detached.
+// T: the datatype of the value(s) produced by the coroutine
+template <class T = void>
+using LazyTask = Task<T, true>;
+
+// Runs a task without waiting for it to complete. The coroutine frame is destroyed when it completes.
+template <class T, bool Lazy>
+void spawn(Task<T, Lazy> task) {
+    std::move(task).detach();
+}
+
+// Result of a task run with withCancellation: whether a void task completed, or the value of a non-void one.
+template <class T>
+using CancelResult = std::conditional_t<std::is_void_v<T>, bool, std::optional<T>>;
+
+// Awaits a task for withCancellation, producing an empty result if it was stopped.
+template <class T, bool Lazy>
+struct StoppableAwaiter {
+    Task<T, Lazy>& task;
+
+    bool await_ready() const noexcept {
+        return task.await_ready();
+    }
+
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> current) const {
+        return task.await_suspend(current);
+    }
+
+    CancelResult<T> await_resume() const {
+        if (task.handle.promise().stopped) return {};
+
+        if constexpr (std::is_void_v<T>) {
+            task.await_resume();
+            return true;
+        } else {
+            return task.await_resume();
+        }
+    }
+};
+
+// Makes the current coroutine the one that stopped tasks return to, and gives it a cancellation token.
+struct CancelBoundary {
+    const CancelToken& token;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template <class Promise>
+    bool await_suspend(std::coroutine_handle<Promise> current) const noexcept {
+        current.promise().cancelBoundary = true;
+        current.promise().cancelToken = token;
+        return false;
+    }
+
+    void await_resume() const noexcept {}
+};
+
+// Runs a task until it completes or the token's source is canceled.
+// The token reaches every task awaited in the chain started by the task, and the I/O operation at the bottom of the
+// chain is canceled without affecting other operations on the same socket. No exception is thrown for cancellation;
+// the stopped coroutines are destroyed without being resumed, and the result is empty instead. Tasks that are not
+// awaited in the chain (e.g. detached ones) are not reached. A nested call keeps its own token and is not reached by
+// the tokens of outer calls.
+template <class T, bool Lazy>
+Task<CancelResult<T>> withCancellation(CancelToken token, Task<T, Lazy> task) {
+    co_await CancelBoundary{ token };
+    co_return co_await StoppableAwaiter<T, Lazy>{ task };
+}
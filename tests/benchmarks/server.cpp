@@ -1,6 +1,7 @@
 // Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
 #include <charconv>
 #include <chrono>
 #include <cstdint>
@@ -8,58 +9,148 @@
 #include <iostream>
 #include <latch>
 #include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "net/device.hpp"
 #include "net/enums.hpp"
 #include "os/async.hpp"
 #include "os/error.hpp"
 #include "sockets/delegates/delegates.hpp"
 #include "sockets/serversocket.hpp"
+#include "sockets/staticsocket.hpp"
 #include "utils/task.hpp"
 
+// Socket used for clients with the static front end
+using StaticIncoming = StaticIncomingSocket<SocketTag::IP>;
+
+// Size of the messages exchanged in the latency test
+constexpr std::size_t pingSize = 64;
+
+// T: the type used to store a client socket (SocketPtr or StaticIncoming)
+template <class T>
 struct Client {
-    SocketPtr sock;
-    bool done;
+    T sock;
+    bool done = false;
 
-    Client(SocketPtr&& sock, bool done) : sock(std::move(sock)), done(done) {}
+    template <class U>
+    explicit Client(U&& sock) : sock(std::forward<U>(sock)) {}
 };
 
-thread_local std::list<Client> clients;
+template <class T>
+thread_local std::list<Client<T>> clients;
+
+// Accesses a socket stored directly or through a pointer.
+template <class T>
+T& deref(T& sock) {
+    return sock;
+}
 
-Task<> loop(SocketPtr& ptr) {
+template <class T>
+T& deref(std::unique_ptr<T>& sock) {
+    return *sock;
+}
+
+// Responds to requests from a client. In the latency test, the data is echoed back instead.
+template <class T, class U>
+Task<> loop(U& accepted, bool echo) {
     static const char* response = "HTTP/1.1 200 OK\r\nConnection: keep-alive\r\nContent-Length: 4\r\nContent-Type: "
                                   "text/html\r\n\r\ntest\r\n\r\n";
 
     co_await Async::queueToThread();
-    Client& client = clients.emplace_front(std::move(ptr), false);
+    Client<T>& client = clients<T>.emplace_front(std::move(accepted));
+    auto& sock = deref(client.sock);
 
+    // Errors are returned instead of thrown, so clients that disconnect do not cost an exception
     while (true) {
-        try {
-            auto result = co_await client.sock->recv(1024);
-            if (result.closed) break;
+        auto result = co_await sock.tryRecv(1024);
+        if (!result || result->closed) break;
 
-            if (result.data.ends_with("\r\n\r\n")) co_await client.sock->send(response);
-        } catch (const System::SystemError&) {
-            break;
-        }
+        System::Expected<void> sent;
+        if (echo) sent = co_await sock.trySend(result->data);
+        else if (result->data.ends_with("\r\n\r\n")) sent = co_await sock.trySend(response);
+        if (!sent) break;
     }
     client.done = true;
 }
 
-Task<> accept(const ServerSocket<SocketTag::IP>& sock, bool& pendingAccept) try {
+template <class T, class S>
+Task<> accept(S& sock, bool& pendingAccept, bool echo) try {
     auto [_, client] = co_await sock.accept();
     pendingAccept = false;
-    co_await loop(client);
+    co_await loop<T>(client, echo);
 } catch (const System::SystemError&) {
     pendingAccept = false;
 }
 
-void run() {
-    const ServerSocket<SocketTag::IP> s;
+// Sends messages to the server one at a time and records the time until each one is echoed back.
+Task<> ping(StaticClientSocket<SocketTag::IP>& sock, std::uint16_t port, std::vector<std::chrono::nanoseconds>& rtts,
+    bool& done) {
+    const std::string message(pingSize, 'x');
+    const Device device{ ConnectionType::TCP, "", "127.0.0.1", port };
+
+    try {
+        co_await sock.connect(device);
+
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            co_await sock.send(message);
+
+            // Messages can arrive in pieces
+            for (std::size_t received = 0; received < message.size();) {
+                auto result = co_await sock.recv(message.size() - received);
+                if (result.closed) throw System::SystemError{ 0, System::ErrorType::System };
+                received += result.data.size();
+            }
+
+            rtts.push_back(std::chrono::steady_clock::now() - start);
+        }
+    } catch (const System::SystemError&) {
+        done = true;
+    }
+}
+
+// Prints the distribution of round-trip times from the latency test.
+void printLatency(std::vector<std::chrono::nanoseconds>& rtts) {
+    if (rtts.empty()) {
+        std::cout << "No round trips completed.\n";
+        return;
+    }
+
+    std::ranges::sort(rtts);
+    auto percentile = [&rtts](double p) {
+        auto rtt = rtts[static_cast<std::size_t>(p * static_cast<double>(rtts.size() - 1))];
+        return std::chrono::duration<double, std::micro>(rtt).count();
+    };
+
+    std::cout << "Round trips: " << rtts.size() << "\n"
+              << "Latency (us): min " << percentile(0) << ", p50 " << percentile(0.5) << ", p99 " << percentile(0.99)
+              << ", p99.9 " << percentile(0.999) << ", max " << percentile(1) << "\n";
+}
+
+// T: the type used to store a client socket
+// S: the type of the server socket
+template <class T, class S>
+void run(const SocketOptions& options, bool latency) {
+    S s;
+    s.setOptions(options);
     const std::uint16_t port = s.startServer({ ConnectionType::TCP, "", "0.0.0.0", 0 }).port;
     std::cout << "port = " << port << "\n";
 
     bool pendingAccept = false;
 
+    // In the latency test, the client runs on the main thread and the server echoes from a worker thread
+    StaticClientSocket<SocketTag::IP> pinger;
+    std::vector<std::chrono::nanoseconds> rtts;
+    bool pingDone = !latency;
+    if (latency) {
+        pinger.setOptions(options);
+        spawn(ping(pinger, port, rtts, pingDone));
+    }
+
     // Run for 10 seconds
     using namespace std::literals;
     const auto start = std::chrono::steady_clock::now();
@@ -68,6 +159,8 @@ void run() {
         if (timeout) {
             s.cancelIO();
             s.close();
+            pinger.cancelIO();
+            pinger.close();
         }
 
         Async::handleEvents();
@@ -75,44 +168,92 @@ void run() {
 
         if (!pendingAccept) {
             pendingAccept = true;
-            accept(s, pendingAccept);
+            spawn(accept<T>(s, pendingAccept, latency));
         }
     }
-}
-
-int main(int argc, char** argv) {
-    // Get number of threads from first command line argument
-    unsigned int numThreads = 0;
-    if (argc > 1) {
-        char* arg = argv[1];
-        std::from_chars_result res = std::from_chars(arg, arg + std::strlen(arg), numThreads);
-        if (res.ec != std::errc{}) std::cout << "Invalid number of threads specified.\n";
-    }
-
-    unsigned int realNumThreads = Async::init(numThreads, 2048);
-    std::cout << "Running with " << realNumThreads << " threads.\n";
 
-    run();
+    // The client refers to the round-trip times, so it must end before they are printed
+    while (!pingDone) Async::handleEvents();
+    if (latency) printLatency(rtts);
+}
 
+template <class T>
+void cleanup(unsigned int numThreads) {
     // Cancel remaining work on all threads
     Async::queueToThreadEx({}, []() -> Task<bool> {
-        for (auto i = clients.begin(); i != clients.end(); i++)
-            if (!i->done) i->sock->cancelIO();
+        for (auto& client : clients<T>)
+            if (!client.done) deref(client.sock).cancelIO();
 
         co_return false;
     });
 
-    std::latch threadWaiter{ realNumThreads - 1 };
+    std::latch threadWaiter{ numThreads - 1 };
     Async::queueToThreadEx({}, [&threadWaiter]() -> Task<bool> {
-        if (clients.empty()) {
+        if (clients<T>.empty()) {
             threadWaiter.count_down();
             co_return false;
         }
 
-        std::erase_if(clients, [](const Client& client) { return client.done; });
+        std::erase_if(clients<T>, [](const Client<T>& client) { return client.done; });
         co_return true;
     });
 
     threadWaiter.wait();
+}
+
+int main(int argc, char** argv) {
+    // Get number of threads from first command line argument
+    unsigned int numThreads = 0;
+    if (argc > 1) {
+        char* arg = argv[1];
+        std::from_chars_result res = std::from_chars(arg, arg + std::strlen(arg), numThreads);
+        if (res.ec != std::errc{}) std::cout << "Invalid number of threads specified.\n";
+    }
+
+    // Remaining arguments select statically dispatched sockets ("static"), the event loop backend on Linux ("epoll" or
+    // "io_uring", automatically chosen if not specified), a ping-pong latency test ("latency"), and busy polling on
+    // Linux ("busypoll=<microseconds>")
+    bool useStatic = false;
+    bool latency = false;
+    unsigned int busyPoll = 0;
+    Async::Backend backend = Async::Backend::Auto;
+    for (int i = 2; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "static") useStatic = true;
+        else if (arg == "epoll") backend = Async::Backend::Epoll;
+        else if (arg == "io_uring") backend = Async::Backend::IOUring;
+        else if (arg == "latency") latency = true;
+        else if (arg.starts_with("busypoll=")) std::from_chars(arg.data() + 9, arg.data() + arg.size(), busyPoll);
+        else std::cout << "Unknown argument: " << arg << "\n";
+    }
+
+    // Busy polling applies to both the event loops and the sockets
+    SocketOptions options{ .noDelay = latency, .busyPoll = busyPoll };
+
+    unsigned int realNumThreads = Async::init(numThreads, 2048, backend, busyPoll);
+    std::cout << "Running with " << realNumThreads << " threads, " << (useStatic ? "static" : "virtual")
+              << " dispatch, " << Async::getBackendName(Async::getBackend()) << " backend.\n";
+
+    // Report the optional event loop features that are active on this host
+    for (const auto& [name, supported, used] : Async::getCapabilities())
+        std::cout << "  " << name << ": " << (supported ? "supported" : "unsupported") << (used ? ", used" : "")
+                  << "\n";
+
+    if (useStatic) {
+        run<StaticIncoming, StaticServerSocket<SocketTag::IP>>(options, latency);
+        cleanup<StaticIncoming>(realNumThreads);
+    } else {
+        run<SocketPtr, ServerSocket<SocketTag::IP>>(options, latency);
+        cleanup<SocketPtr>(realNumThreads);
+    }
+
+    // Report whether the rings were large enough for the load
+    if (Async::getBackend() == Async::Backend::IOUring) {
+        auto stats = Async::getRingStats();
+        std::cout << "Ring entries: " << stats.sqEntries << " submission, " << stats.cqEntries << " completion\n"
+                  << "Completion queue overflows: " << stats.overflows << " (" << stats.dropped << " dropped, "
+                  << stats.resizes << " resizes)\n";
+    }
+
     Async::cleanup();
 }
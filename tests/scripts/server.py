@@ -56,6 +56,20 @@ match args.transport:
             HOST = socket.BDADDR_ANY
         else:
             raise Exception("L2CAP is only available on Linux")
+    case "UnixStream" | "UnixSeqPacket":
+        if sys.platform == "win32":
+            raise Exception("Unix sockets are not available on Windows")
+
+        is_stream = args.transport == "UnixStream"
+        SOCKET_TYPE = socket.SOCK_STREAM if is_stream else socket.SOCK_SEQPACKET
+        SOCKET_FAMILY = socket.AF_UNIX
+        SOCKET_PROTO = 0
+        PORT = None
+        HOST = config["unix"]["streamPath" if is_stream else "seqPacketPath"]
+
+        # Abstract names are written with a leading @ in the settings file
+        if HOST.startswith("@"):
+            HOST = "\0" + HOST[1:]
     case _:
         raise Exception("Unsupported transport")
 
@@ -64,7 +78,9 @@ match args.transport:
 def server_loop_tcp(s: socket.socket) -> None:
     # Wait for new client connections
     conn, addr = s.accept()
-    peer_addr = addr[0]
+
+    # Unix socket clients have a (possibly empty) path instead of an address tuple
+    peer_addr = addr[0] if isinstance(addr, tuple) else addr or "unnamed client"
 
     print(f"New connection from {peer_addr}")
 
@@ -111,14 +127,21 @@ with socket.socket(SOCKET_FAMILY, SOCKET_TYPE, SOCKET_PROTO) as s:
     if SOCKET_FAMILY == socket.AF_INET6:
         s.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_V6ONLY, 0)
 
-    s.bind((HOST, PORT))
+    if SOCKET_FAMILY == socket.AF_UNIX:
+        # Remove the socket file from a previous run
+        if not HOST.startswith("\0"):
+            pathlib.Path(HOST).unlink(missing_ok=True)
+
+        s.bind(HOST)
+    else:
+        s.bind((HOST, PORT))
 
     # Listen on connection-based sockets
     is_dgram = SOCKET_TYPE == socket.SOCK_DGRAM
     if not is_dgram:
         s.listen()
 
-    print(f"Server is active on port {PORT}")
+    print(f"Server is active on {HOST!r}" if PORT is None else f"Server is active on port {PORT}")
 
     # Handle clients until termination
     while True:
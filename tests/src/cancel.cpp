@@ -27,14 +27,29 @@ TEST_CASE("Cancellation") {
     runSync([&]() -> Task<> { co_await sock.connect({ ConnectionType::TCP, "", v4Addr, tcpPort }); });
 
     bool running = true;
-    [&]() -> Task<> {
+    auto recv = [&]() -> Task<> {
         try {
             co_await sock.recv(4);
         } catch (const System::SystemError& e) {
             CHECK(e.isCanceled());
             running = false;
         }
-    }();
+    };
+
+    // The cancellation is returned instead of thrown
+    auto tryRecv = [&]() -> Task<> {
+        auto result = co_await sock.tryRecv(4);
+        CHECK((!result && result.error().isCanceled()));
+        running = false;
+    };
+
+    SECTION("Thrown errors") {
+        spawn(recv());
+    }
+
+    SECTION("Returned errors") {
+        spawn(tryRecv());
+    }
 
     int iterations = 0;
     while (running) {
@@ -0,0 +1,213 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Packet capture is only implemented on Linux
+#if OS_LINUX
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "helpers/helpers.hpp"
+#include "net/capture.hpp"
+#include "net/enums.hpp"
+#include "os/error.hpp"
+#include "utils/task.hpp"
+
+using Bytes = std::vector<std::uint8_t>;
+
+// Addresses of the packets, from the documentation ranges
+constexpr std::array<std::uint8_t, 4> v4Local{ 192, 0, 2, 1 };
+constexpr std::array<std::uint8_t, 4> v4Remote{ 192, 0, 2, 2 };
+constexpr std::array<std::uint8_t, 16> v6Local{ 0x20, 0x01, 0x0D, 0xB8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+constexpr std::array<std::uint8_t, 16> v6Remote{ 0x20, 0x01, 0x0D, 0xB8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2 };
+
+// Builds a network layer packet with a TCP or UDP header. The IP version is chosen by the size of the addresses.
+// Options are added to the IPv4 and TCP headers with the given sizes, which must be multiples of 4.
+Bytes makePacket(std::span<const std::uint8_t> src, std::uint16_t srcPort, std::span<const std::uint8_t> dest,
+    std::uint16_t destPort, std::uint8_t protocol, std::string_view payload, std::size_t ipOptions = 0,
+    std::size_t tcpOptions = 0) {
+    bool isV4 = src.size() == 4;
+    std::size_t ipSize = isV4 ? 20 + ipOptions : 40;
+    std::size_t transportSize = protocol == IPPROTO_TCP ? 20 + tcpOptions : 8;
+    Bytes packet(ipSize + transportSize);
+
+    if (isV4) {
+        packet[0] = static_cast<std::uint8_t>(0x40 | (ipSize / 4));
+        packet[9] = protocol;
+        std::ranges::copy(src, packet.begin() + 12);
+        std::ranges::copy(dest, packet.begin() + 16);
+    } else {
+        packet[0] = 0x60;
+        packet[6] = protocol;
+        std::ranges::copy(src, packet.begin() + 8);
+        std::ranges::copy(dest, packet.begin() + 24);
+    }
+
+    packet[ipSize] = srcPort >> 8;
+    packet[ipSize + 1] = srcPort & 0xFF;
+    packet[ipSize + 2] = destPort >> 8;
+    packet[ipSize + 3] = destPort & 0xFF;
+
+    // Data offset of the TCP header, in 32-bit words
+    if (protocol == IPPROTO_TCP) packet[ipSize + 12] = static_cast<std::uint8_t>((transportSize / 4) << 4);
+
+    packet.insert(packet.end(), payload.begin(), payload.end());
+    return packet;
+}
+
+// Builds the BPF program for a filter.
+std::vector<sock_filter> buildFilter(const CaptureFilter& filter) {
+    std::vector<sock_filter> program;
+    runSync([&]() -> Task<> { program = co_await makeFilter(filter); });
+    return program;
+}
+
+// Checks if a BPF program accepts a packet.
+// The program is attached to the receiving end of a Unix datagram socket pair, which runs it on each message without
+// needing CAP_NET_RAW. Messages start at the network layer header, the same as captured packets.
+bool accepts(const std::vector<sock_filter>& program, const Bytes& packet) {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, fds) == 0);
+
+    sock_fprog fprog{ static_cast<unsigned short>(program.size()), const_cast<sock_filter*>(program.data()) };
+    REQUIRE(setsockopt(fds[1], SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) == 0);
+
+    // Rejected messages are dropped without returning an error to the sender
+    REQUIRE(send(fds[0], packet.data(), packet.size(), 0) == static_cast<ssize_t>(packet.size()));
+
+    std::array<std::uint8_t, 2048> received;
+    bool accepted = recv(fds[1], received.data(), received.size(), MSG_DONTWAIT) == static_cast<ssize_t>(packet.size());
+
+    close(fds[0]);
+    close(fds[1]);
+    return accepted;
+}
+
+// Gets the payload of a packet as a string.
+std::string getPayloadString(const Bytes& packet) {
+    auto payload = getPacketPayload(packet);
+    return { payload.begin(), payload.end() };
+}
+
+TEST_CASE("Capture filters") {
+    using enum ConnectionType;
+
+    SECTION("Connection") {
+        auto program = buildFilter({ TCP, "192.0.2.2", 443, "192.0.2.1", 51000 });
+
+        // Both directions are captured
+        CHECK(accepts(program, makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "in")));
+        CHECK(accepts(program, makePacket(v4Local, 51000, v4Remote, 443, IPPROTO_TCP, "out")));
+
+        // Ports are found after IPv4 options
+        CHECK(accepts(program, makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "", 8)));
+
+        // Other connections and protocols are not
+        CHECK_FALSE(accepts(program, makePacket(v4Remote, 443, v4Local, 51001, IPPROTO_TCP, "")));
+        CHECK_FALSE(accepts(program, makePacket(v4Remote, 80, v4Local, 51000, IPPROTO_TCP, "")));
+        CHECK_FALSE(accepts(program, makePacket(v4Local, 443, v4Remote, 51000, IPPROTO_TCP, "")));
+        CHECK_FALSE(accepts(program, makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_UDP, "")));
+        CHECK_FALSE(accepts(program, makePacket(v6Remote, 443, v6Local, 51000, IPPROTO_TCP, "")));
+    }
+
+    SECTION("IPv6") {
+        auto program = buildFilter({ UDP, "2001:db8::2", 53, "", 0 });
+
+        CHECK(accepts(program, makePacket(v6Remote, 53, v6Local, 40000, IPPROTO_UDP, "")));
+        CHECK(accepts(program, makePacket(v6Local, 40000, v6Remote, 53, IPPROTO_UDP, "")));
+        CHECK_FALSE(accepts(program, makePacket(v6Remote, 54, v6Local, 40000, IPPROTO_UDP, "")));
+        CHECK_FALSE(accepts(program, makePacket(v4Remote, 53, v4Local, 40000, IPPROTO_UDP, "")));
+    }
+
+    SECTION("Any address") {
+        auto program = buildFilter({ TCP, "", 0, "", 0 });
+
+        CHECK(accepts(program, makePacket(v4Remote, 1, v4Local, 2, IPPROTO_TCP, "")));
+        CHECK(accepts(program, makePacket(v6Remote, 1, v6Local, 2, IPPROTO_TCP, "")));
+        CHECK_FALSE(accepts(program, makePacket(v4Remote, 1, v4Local, 2, IPPROTO_UDP, "")));
+    }
+
+    SECTION("Fragments and truncated packets") {
+        auto program = buildFilter({ TCP, "192.0.2.2", 443, "", 0 });
+
+        // Only the first fragment has the ports
+        auto fragment = makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "");
+        fragment[7] = 1;
+        CHECK_FALSE(accepts(program, fragment));
+
+        // Packets that end before the ports cannot be matched
+        auto truncated = makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "");
+        truncated.resize(21);
+        CHECK_FALSE(accepts(program, truncated));
+    }
+
+    SECTION("Mixed IP versions") {
+        CHECK_THROWS_AS(buildFilter({ TCP, "192.0.2.2", 0, "2001:db8::1", 0 }), System::SystemError);
+    }
+}
+
+TEST_CASE("Captured packet parsing") {
+    SECTION("IPv4 TCP") {
+        auto packet = makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "hello");
+        CHECK(formatPacketHeaders(packet) == "192.0.2.2:443 > 192.0.2.1:51000 TCP");
+        CHECK(getPayloadString(packet) == "hello");
+    }
+
+    SECTION("Header options") {
+        // The payload starts after the options of both headers
+        auto packet = makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "hello", 8, 12);
+        CHECK(formatPacketHeaders(packet) == "192.0.2.2:443 > 192.0.2.1:51000 TCP");
+        CHECK(getPacketPayload(packet).data() == packet.data() + 60);
+        CHECK(getPayloadString(packet) == "hello");
+    }
+
+    SECTION("IPv6 UDP") {
+        auto packet = makePacket(v6Remote, 53, v6Local, 40000, IPPROTO_UDP, "query");
+        CHECK(formatPacketHeaders(packet) == "[2001:db8::2]:53 > [2001:db8::1]:40000 UDP");
+        CHECK(getPacketPayload(packet).data() == packet.data() + 48);
+        CHECK(getPayloadString(packet) == "query");
+    }
+
+    SECTION("Other protocols") {
+        // ICMP packets have no ports or payload
+        auto packet = makePacket(v4Remote, 0, v4Local, 0, IPPROTO_ICMP, "ping");
+        CHECK(formatPacketHeaders(packet) == "192.0.2.2 > 192.0.2.1 IP");
+        CHECK(getPacketPayload(packet).empty());
+    }
+
+    SECTION("Truncated packets") {
+        auto packet = makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "hello");
+
+        // Only the addresses are shown if the ports were not captured
+        Bytes noPorts{ packet.begin(), packet.begin() + 22 };
+        CHECK(formatPacketHeaders(noPorts) == "192.0.2.2 > 192.0.2.1 TCP");
+        CHECK(getPacketPayload(noPorts).empty());
+
+        // The payload cannot be found if the TCP header is incomplete
+        Bytes partialHeader{ packet.begin(), packet.begin() + 30 };
+        CHECK(formatPacketHeaders(partialHeader) == "192.0.2.2:443 > 192.0.2.1:51000 TCP");
+        CHECK(getPacketPayload(partialHeader).empty());
+
+        // Or if the header is longer than the packet
+        Bytes longHeader = makePacket(v4Remote, 443, v4Local, 51000, IPPROTO_TCP, "");
+        longHeader[32] = 0xF0;
+        CHECK(getPacketPayload(longHeader).empty());
+
+        // Packets without a full IP header are not parsed
+        CHECK(formatPacketHeaders(Bytes{ packet.begin(), packet.begin() + 10 }) == "Unknown packet");
+        CHECK(formatPacketHeaders(Bytes{}) == "Unknown packet");
+        CHECK(getPacketPayload(Bytes{}).empty());
+    }
+}
+#endif
@@ -0,0 +1,83 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "os/async.hpp"
+#include "os/channel.hpp"
+#include "utils/task.hpp"
+
+TEST_CASE("Channels") {
+    SECTION("Values arrive in order") {
+        // A capacity of 0 makes every send wait for a receiver
+        for (std::size_t capacity : { 0, 1, 16 }) {
+            Async::Channel<int> channel{ capacity };
+
+            auto producer = [&]() -> Task<> {
+                for (int i = 0; i < 100; i++) co_await channel.send(i);
+                channel.close();
+            };
+
+            std::vector<int> received;
+            bool done = false;
+            auto consumer = [&]() -> Task<> {
+                while (auto value = co_await channel.recv()) received.push_back(*value);
+                done = true;
+            };
+
+            auto producerTask = producer();
+            auto consumerTask = consumer();
+            while (!done) Async::handleEvents(false);
+
+            REQUIRE(received.size() == 100);
+            for (int i = 0; i < 100; i++) CHECK(received[i] == i);
+        }
+    }
+
+    SECTION("Values can be sent from other threads") {
+        Async::Channel<std::string> channel{ 4 };
+        std::thread sender{ [&] {
+            for (int i = 0; i < 100; i++) {
+                std::string value = std::to_string(i);
+                while (!channel.trySend(std::move(value))) std::this_thread::yield();
+            }
+            channel.close();
+        } };
+
+        int count = 0;
+        bool done = false;
+        auto consumer = [&]() -> Task<> {
+            while (auto value = co_await channel.recv()) CHECK(*value == std::to_string(count++));
+            done = true;
+        };
+
+        auto consumerTask = consumer();
+        while (!done) Async::handleEvents(false);
+        sender.join();
+        CHECK(count == 100);
+    }
+
+    SECTION("Closing wakes waiting senders") {
+        Async::Channel<int> channel{ 0 };
+        bool sent = true;
+        bool done = false;
+        auto producer = [&]() -> Task<> {
+            sent = co_await channel.send(1);
+            done = true;
+        };
+
+        auto producerTask = producer();
+        CHECK_FALSE(done);
+
+        channel.close();
+        while (!done) Async::handleEvents(false);
+        CHECK_FALSE(sent);
+        CHECK_FALSE(channel.tryRecv());
+    }
+}
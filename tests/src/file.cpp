@@ -0,0 +1,78 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "helpers/helpers.hpp"
+#include "os/async.hpp"
+#include "os/error.hpp"
+#include "os/file.hpp"
+#include "utils/task.hpp"
+
+TEST_CASE("File I/O") {
+    const auto path = (std::filesystem::temp_directory_path() / "whaleconnect-file-test.txt").string();
+
+    // The co_await expressions are outside the CHECK() macros to prevent them from being evaluated multiple times.
+    runSync([&]() -> Task<> {
+        File file;
+        co_await file.open(path, Async::FileMode::Write);
+        auto written = co_await file.write("Hello world");
+        CHECK(written == 11);
+
+        // Writes at an offset replace existing data
+        written = co_await file.write("W", 6);
+        CHECK(written == 1);
+
+        co_await file.sync();
+        co_await file.close();
+        CHECK_FALSE(file.isOpen());
+    });
+
+    SECTION("Read") {
+        runSync([&]() -> Task<> {
+            File file;
+            co_await file.open(path, Async::FileMode::Read);
+
+            auto data = co_await file.read(5);
+            CHECK(data == "Hello");
+
+            data = co_await file.read(100);
+            CHECK(data == " World");
+
+            // An empty string is returned at the end of the file
+            data = co_await file.read(100);
+            CHECK(data.empty());
+
+            data = co_await file.read(5, 6);
+            CHECK(data == "World");
+        });
+    }
+
+    SECTION("Append") {
+        runSync([&]() -> Task<> {
+            File file;
+            co_await file.open(path, Async::FileMode::Append);
+            co_await file.write("!");
+            co_await file.close();
+
+            co_await file.open(path, Async::FileMode::Read);
+            auto data = co_await file.read(100);
+            CHECK(data == "Hello World!");
+        });
+    }
+
+    SECTION("Missing file") {
+        auto open = [&]() -> Task<> {
+            File file;
+            co_await file.open(path + ".missing", Async::FileMode::Read);
+        };
+
+        CHECK_THROWS_AS(runSync(open), System::SystemError);
+    }
+
+    std::remove(path.c_str());
+}
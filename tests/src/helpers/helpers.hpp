@@ -32,7 +32,8 @@ void runSync(const Awaitable auto& fn, bool useRunLoop = false) {
     std::exception_ptr ptr;
 
     // Run an outer coroutine, but don't await it
-    [&]() -> Task<> {
+    // The lambda is kept until the coroutine completes, since the coroutine refers to its captures.
+    auto outer = [&]() -> Task<> {
         try {
             // Await the given coroutine
             co_await fn();
@@ -49,7 +50,8 @@ void runSync(const Awaitable auto& fn, bool useRunLoop = false) {
         } else {
             completed = true;
         }
-    }();
+    };
+    outer();
 
     // Wait for the completion condition
     if (hasRunLoop) {
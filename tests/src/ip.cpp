@@ -1,14 +1,20 @@
 // Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <filesystem>
 #include <string>
 
 #include <catch2/catch_test_macros.hpp>
 
+#include "helpers/helpers.hpp"
 #include "helpers/testio.hpp"
 #include "net/enums.hpp"
+#include "os/async.hpp"
+#include "os/file.hpp"
 #include "sockets/clientsocket.hpp"
+#include "sockets/staticsocket.hpp"
 #include "utils/settingsparser.hpp"
+#include "utils/task.hpp"
 
 TEST_CASE("I/O (Internet Protocol)") {
     SettingsParser parser;
@@ -44,4 +50,62 @@ TEST_CASE("I/O (Internet Protocol)") {
             testIOClient(s, { UDP, "", v6Addr, udpPort });
         }
     }
+
+    SECTION("Statically dispatched sockets") {
+        StaticClientSocket<SocketTag::IP> s;
+
+        runSync([&s, &v4Addr, tcpPort]() -> Task<> {
+            constexpr const char* echoString = "echo test";
+
+            co_await s.connect({ TCP, "", v4Addr, tcpPort });
+            co_await s.send(echoString);
+
+            auto recvResult = co_await s.recv(1024);
+            CHECK(recvResult.data == echoString);
+        });
+    }
+
+    SECTION("Sending files") {
+        const auto path = (std::filesystem::temp_directory_path() / "whaleconnect-sendfile-test.txt").string();
+        ClientSocketIP s;
+
+        runSync([&]() -> Task<> {
+            File file;
+            co_await file.open(path, Async::FileMode::Write);
+            co_await file.write("file test");
+            co_await file.close();
+
+            co_await s.connect({ TCP, "", v4Addr, tcpPort });
+            co_await file.open(path, Async::FileMode::Read);
+
+            // The second call reaches the end of the file
+            auto sent = co_await s.sendFile(file, 0, 1024);
+            CHECK(sent == 9);
+            sent = co_await s.sendFile(file, 9, 1024);
+            CHECK(sent == 0);
+
+            auto recvResult = co_await s.recv(1024);
+            CHECK(recvResult.data == "file test");
+        });
+
+        std::filesystem::remove(path);
+    }
+
+#if OS_LINUX
+    SECTION("Kernel timestamps") {
+        ClientSocketIP s;
+        s.setOptions({ .timestamps = true });
+
+        runSync([&]() -> Task<> {
+            co_await s.connect({ TCP, "", v4Addr, tcpPort });
+            auto sentTime = co_await s.sendTimestamped("timestamp test");
+
+            // The echo is received after the data is transmitted
+            auto recvResult = co_await s.recv(1024);
+            CHECK(recvResult.data == "timestamp test");
+            CHECK(sentTime > 0);
+            CHECK(recvResult.timestamp >= sentTime);
+        });
+    }
+#endif
 }
@@ -0,0 +1,78 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "helpers/helpers.hpp"
+#include "os/async.hpp"
+#include "os/error.hpp"
+#include "utils/task.hpp"
+
+// Readiness polls are not supported on Windows
+#if !OS_WINDOWS
+#include <unistd.h>
+
+TEST_CASE("File descriptor readiness") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+
+    SECTION("Writable") {
+        runSync([&]() -> Task<> { co_await Async::writable(fds[1]); });
+    }
+
+    SECTION("Readable") {
+        bool ready = false;
+        [&]() -> Task<> {
+            co_await Async::readable(fds[0]);
+            ready = true;
+        }();
+
+        // Nothing has been written yet
+        for (int i = 0; i < 5; i++) Async::handleEvents(false);
+        CHECK_FALSE(ready);
+
+        REQUIRE(write(fds[1], "a", 1) == 1);
+        while (!ready) Async::handleEvents();
+    }
+
+    SECTION("Repeated") {
+        Async::Poller poller{ fds[0] };
+
+        for (int i = 0; i < 3; i++) {
+            REQUIRE(write(fds[1], "a", 1) == 1);
+            runSync([&]() -> Task<> { co_await poller.next(); });
+
+            char c;
+            REQUIRE(read(fds[0], &c, 1) == 1);
+        }
+    }
+
+    SECTION("Canceled") {
+        Async::Poller poller{ fds[0] };
+
+        bool running = true;
+        [&]() -> Task<> {
+            try {
+                co_await poller.next();
+            } catch (const System::SystemError& e) {
+                CHECK(e.isCanceled());
+                running = false;
+            }
+        }();
+
+        int iterations = 0;
+        while (running) {
+            Async::handleEvents(false);
+            if (iterations == 5) poller.cancel();
+
+            iterations++;
+        }
+    }
+
+    // Pollers submit their cancellation when destroyed, it needs to run before the pipe is closed
+    Async::handleEvents(false);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
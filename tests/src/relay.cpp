@@ -0,0 +1,49 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string>
+#include <string_view>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "helpers/helpers.hpp"
+#include "net/device.hpp"
+#include "net/enums.hpp"
+#include "net/relay.hpp"
+#include "sockets/staticsocket.hpp"
+#include "utils/settingsparser.hpp"
+#include "utils/task.hpp"
+
+TEST_CASE("TCP relay") {
+    SettingsParser parser;
+    parser.load(SETTINGS_FILE);
+
+    const auto v4Addr = parser.get<std::string>("ip", "v4");
+    const auto tcpPort = parser.get<std::uint16_t>("ip", "tcpPort");
+
+    using enum ConnectionType;
+
+    // Relay to the echo server
+    bool hasError = false;
+    Relay relay{ { TCP, "", v4Addr, 0 }, { TCP, "", v4Addr, tcpPort }, {},
+        [&hasError](std::string_view, bool isError) { hasError |= isError; } };
+
+    const Device relayDevice{ TCP, "", v4Addr, relay.getAddress().port };
+    relay.update();
+
+    constexpr std::string_view echoString = "relay test";
+
+    StaticClientSocket<SocketTag::IP> s;
+    runSync([&]() -> Task<> {
+        co_await s.connect(relayDevice);
+        co_await s.send(echoString);
+
+        auto recvResult = co_await s.recv(1024);
+        CHECK(recvResult.data == echoString);
+    });
+
+    const RelayStats& stats = relay.getStats();
+    CHECK_FALSE(hasError);
+    CHECK(stats.accepted == 1);
+    CHECK(stats.toTarget == echoString.size());
+}
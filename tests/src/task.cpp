@@ -0,0 +1,566 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !OS_WINDOWS
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "helpers/helpers.hpp"
+#include "os/async.hpp"
+#include "os/combinators.hpp"
+#include "os/error.hpp"
+#include "os/generator.hpp"
+#include "os/offload.hpp"
+#include "utils/cancellation.hpp"
+#include "utils/task.hpp"
+
+// Counts how many instances are alive, to check when coroutine frames are destroyed.
+struct FrameCounter {
+    static inline int alive = 0;
+
+    FrameCounter() {
+        alive++;
+    }
+
+    FrameCounter(const FrameCounter&) = delete;
+
+    ~FrameCounter() {
+        alive--;
+    }
+};
+
+Task<int> immediate() {
+    FrameCounter counter;
+    co_return 1;
+}
+
+LazyTask<int> lazy(bool& started) {
+    FrameCounter counter;
+    started = true;
+    co_return 2;
+}
+
+// Allocator that counts the frames allocated and freed with it.
+template <class T>
+struct CountingAllocator {
+    using value_type = T;
+
+    int* count;
+
+    explicit CountingAllocator(int& count) : count(&count) {}
+
+    template <class U>
+    explicit CountingAllocator(const CountingAllocator<U>& other) : count(other.count) {}
+
+    T* allocate(std::size_t n) {
+        ++*count;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        --*count;
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    bool operator==(const CountingAllocator&) const = default;
+};
+
+Task<int> allocated(std::allocator_arg_t, const CountingAllocator<int>&, int value) {
+    co_return value;
+}
+
+TEST_CASE("Task ownership") {
+    SECTION("Completed frames are destroyed") {
+        runSync([]() -> Task<> {
+            int value = co_await immediate();
+            CHECK(value == 1);
+        });
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    SECTION("Lazy tasks start when awaited") {
+        bool started = false;
+        runSync([&]() -> Task<> {
+            auto task = lazy(started);
+            CHECK_FALSE(started);
+
+            int value = co_await task;
+            CHECK(value == 2);
+        });
+        CHECK(started);
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    SECTION("Unstarted lazy tasks are destroyed") {
+        bool started = false;
+        lazy(started);
+        CHECK_FALSE(started);
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    SECTION("Frames can use a custom allocator") {
+        int count = 0;
+        runSync([&]() -> Task<> {
+            CountingAllocator<int> alloc{ count };
+            auto task = allocated(std::allocator_arg, alloc, 3);
+            CHECK(count == 1);
+
+            int value = co_await task;
+            CHECK(value == 3);
+        });
+        CHECK(count == 0);
+    }
+
+#if !OS_WINDOWS
+    SECTION("Detached tasks destroy their frames on completion") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+
+        bool done = false;
+        auto waiter = [&]() -> Task<> {
+            FrameCounter counter;
+            co_await Async::readable(fds[0]);
+            done = true;
+        };
+        spawn(waiter());
+
+        // The coroutine keeps running after its task object is gone
+        CHECK(FrameCounter::alive == 1);
+        REQUIRE(write(fds[1], "a", 1) == 1);
+        while (!done) Async::handleEvents();
+        CHECK(FrameCounter::alive == 0);
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+#endif
+}
+
+// Yields numbers up to a count, then optionally throws.
+Async::Generator<int> countUp(int count, bool fail) {
+    FrameCounter counter;
+    for (int i = 0; i < count; i++) co_yield i;
+    if (fail) throw System::SystemError{ 1, System::ErrorType::System };
+}
+
+TEST_CASE("Generators") {
+    SECTION("Values are produced in order") {
+        runSync([]() -> Task<> {
+            auto generator = countUp(5, false);
+            std::vector<int> values;
+            while (auto value = co_await generator.next()) values.push_back(*value);
+            CHECK(values == std::vector{ 0, 1, 2, 3, 4 });
+
+            auto end = co_await generator.next();
+            CHECK_FALSE(end);
+        });
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    SECTION("Exceptions are rethrown after the last value") {
+        runSync([]() -> Task<> {
+            auto generator = countUp(2, true);
+            int count = 0;
+            bool thrown = false;
+            try {
+                while (co_await generator.next()) count++;
+            } catch (const System::SystemError&) {
+                thrown = true;
+            }
+            CHECK(count == 2);
+            CHECK(thrown);
+        });
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    SECTION("Unfinished generators are destroyed") {
+        runSync([]() -> Task<> {
+            auto generator = countUp(5, false);
+            auto value = co_await generator.next();
+            CHECK(value == 0);
+        });
+        CHECK(FrameCounter::alive == 0);
+    }
+}
+
+TEST_CASE("Executors") {
+    // The tests run without worker threads, so every executor hop stays on the main thread
+    Async::Executor mainExecutor = Async::getMainExecutor();
+    REQUIRE(mainExecutor.isCurrent());
+
+    SECTION("Resuming on an executor") {
+        runSync([&]() -> Task<> {
+            co_await Async::resumeOn(mainExecutor);
+            CHECK(mainExecutor.isCurrent());
+
+            co_await Async::queueToThread();
+            CHECK(mainExecutor.isCurrent());
+        });
+    }
+
+    SECTION("Running tasks on an executor") {
+        runSync([&]() -> Task<> {
+            int value = co_await Async::runOn(mainExecutor, []() -> LazyTask<int> { co_return 4; }());
+            CHECK(value == 4);
+
+            bool thrown = false;
+            try {
+                co_await Async::runOn(mainExecutor, []() -> LazyTask<> {
+                    throw System::SystemError{ 1, System::ErrorType::System };
+                    co_return;
+                }());
+            } catch (const System::SystemError&) {
+                thrown = true;
+            }
+            CHECK(thrown);
+        });
+    }
+}
+
+TEST_CASE("Offloading blocking work") {
+    SECTION("Results return to the awaiting thread") {
+        runSync([]() -> Task<> {
+            auto caller = std::this_thread::get_id();
+            auto worker = co_await Async::offload([] { return std::this_thread::get_id(); });
+            CHECK(worker != caller);
+            CHECK(std::this_thread::get_id() == caller);
+        });
+    }
+
+    SECTION("Exceptions are rethrown") {
+        runSync([]() -> Task<> {
+            bool thrown = false;
+            try {
+                co_await Async::offload([] { throw System::SystemError{ 1, System::ErrorType::System }; });
+            } catch (const System::SystemError&) {
+                thrown = true;
+            }
+            CHECK(thrown);
+        });
+    }
+
+    SECTION("Destroying the owner of a queued job drops its result") {
+        // Object whose state is written when the job finishes, and which cancels the job when it is destroyed
+        struct Owner {
+            CancelSource cancel;
+            int value = 0;
+
+            ~Owner() {
+                cancel.cancel();
+            }
+
+            Task<> lookup(std::shared_ptr<std::atomic_bool> release) {
+                FrameCounter counter;
+                auto wait = [release] {
+                    release->wait(false);
+                    return 1;
+                };
+                value = co_await Async::offload(std::move(wait));
+            }
+        };
+
+        // The flag is shared with the job, which finishes after this section
+        auto release = std::make_shared<std::atomic_bool>(false);
+        auto owner = std::make_unique<Owner>();
+        bool done = false;
+        bool completed = true;
+        auto start = [&]() -> Task<> {
+            completed = co_await withCancellation(owner->cancel.getToken(), owner->lookup(release));
+            done = true;
+        };
+
+        auto task = start();
+        owner.reset();
+        while (!done) Async::handleEvents();
+        CHECK_FALSE(completed);
+        CHECK(FrameCounter::alive == 0);
+
+        // The job still finishes, without resuming into the destroyed owner
+        *release = true;
+        release->notify_one();
+    }
+}
+
+#if !OS_WINDOWS
+// Waits for a byte to be written to a pipe, then returns a value.
+Task<int> readByte(int fd, int value) {
+    co_await Async::readable(fd);
+
+    char c;
+    if (read(fd, &c, 1) != 1) throw System::SystemError{ errno, System::ErrorType::System };
+    co_return value;
+}
+
+TEST_CASE("Task combinators") {
+    int first[2];
+    int second[2];
+    REQUIRE(pipe(first) == 0);
+    REQUIRE(pipe(second) == 0);
+
+    SECTION("All") {
+        REQUIRE(write(second[1], "a", 1) == 1);
+        REQUIRE(write(first[1], "a", 1) == 1);
+
+        runSync([&]() -> Task<> {
+            std::vector<Task<int>> tasks;
+            tasks.push_back(readByte(first[0], 1));
+            tasks.push_back(readByte(second[0], 2));
+
+            auto values = co_await Async::whenAll(std::move(tasks));
+            CHECK(values == std::vector{ 1, 2 });
+        });
+    }
+
+    SECTION("All with errors") {
+        // Waiting on an invalid descriptor fails
+        REQUIRE(write(first[1], "a", 1) == 1);
+
+        runSync([&]() -> Task<> {
+            std::vector<Task<int>> tasks;
+            tasks.push_back(readByte(first[0], 1));
+            tasks.push_back(readByte(-1, 2));
+
+            std::size_t numErrors = 0;
+            try {
+                co_await Async::whenAll(std::move(tasks));
+            } catch (const Async::TaskErrors& e) {
+                numErrors = e.getErrors().size();
+            }
+            CHECK(numErrors == 1);
+        });
+    }
+
+    SECTION("Any") {
+        REQUIRE(write(second[1], "a", 1) == 1);
+
+        runSync([&]() -> Task<> {
+            std::vector<Task<int>> tasks;
+            tasks.push_back(readByte(first[0], 1));
+            tasks.push_back(readByte(second[0], 2));
+
+            // The first pipe is never written to, so its read is canceled
+            auto result = co_await Async::whenAny(std::move(tasks), [&](std::size_t i) {
+                CHECK(i == 0);
+                Async::submit(Async::Cancel{ { first[0], nullptr } });
+            });
+            CHECK(result.index == 1);
+            CHECK(result.value == 2);
+        });
+    }
+
+    for (int fd : { first[0], first[1], second[0], second[1] }) close(fd);
+}
+
+// Awaits readByte through another task, to check that cancellation reaches nested tasks.
+Task<int> readByteNested(int fd, int value) {
+    FrameCounter counter;
+    int result = co_await readByte(fd, value);
+    co_return result;
+}
+
+TEST_CASE("Task cancellation") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+
+    SECTION("Canceling stops only the operation of the task") {
+        CancelSource source;
+        bool done = false;
+        std::optional<int> result = 0;
+        auto canceled = [&]() -> Task<> {
+            result = co_await withCancellation(source.getToken(), readByteNested(fds[0], 1));
+            done = true;
+        };
+
+        // Another wait on the same pipe is not affected
+        bool otherDone = false;
+        auto other = [&]() -> Task<> {
+            co_await Async::readable(fds[0]);
+            otherDone = true;
+        };
+
+        auto canceledTask = canceled();
+        auto otherTask = other();
+        Async::handleEvents(false);
+        source.cancel();
+        while (!done) Async::handleEvents();
+
+        CHECK_FALSE(result);
+        CHECK(FrameCounter::alive == 0);
+        CHECK_FALSE(otherDone);
+
+        REQUIRE(write(fds[1], "a", 1) == 1);
+        while (!otherDone) Async::handleEvents();
+    }
+
+    SECTION("Tasks that complete return their values") {
+        REQUIRE(write(fds[1], "a", 1) == 1);
+
+        CancelSource source;
+        runSync([&]() -> Task<> {
+            auto result = co_await withCancellation(source.getToken(), readByteNested(fds[0], 2));
+            CHECK(result == 2);
+        });
+    }
+
+    SECTION("Tasks canceled before they start do not submit operations") {
+        CancelSource source;
+        source.cancel();
+
+        runSync([&]() -> Task<> {
+            bool completed = co_await withCancellation(source.getToken(), []() -> LazyTask<> {
+                FrameCounter counter;
+                co_await Async::readable(-1);
+            }());
+            CHECK_FALSE(completed);
+        });
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    SECTION("Cancellation reaches operations in generators") {
+        auto bytes = [](int fd) -> Async::Generator<char> {
+            FrameCounter counter;
+            while (true) {
+                co_await Async::readable(fd);
+
+                char c;
+                if (read(fd, &c, 1) != 1) co_return;
+                co_yield c;
+            }
+        };
+
+        CancelSource source;
+        std::string received;
+        bool done = false;
+        bool completed = true;
+        auto reader = [&]() -> Task<> {
+            auto generator = bytes(fds[0]);
+            while (auto c = co_await generator.next()) received += *c;
+        };
+        auto canceled = [&]() -> Task<> {
+            completed = co_await withCancellation(source.getToken(), reader());
+            done = true;
+        };
+
+        auto canceledTask = canceled();
+        REQUIRE(write(fds[1], "ab", 2) == 2);
+        while (received.size() < 2) Async::handleEvents();
+
+        source.cancel();
+        while (!done) Async::handleEvents();
+        CHECK(received == "ab");
+        CHECK_FALSE(completed);
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// Waits for a pipe to become readable, then records the thread it was resumed on.
+Task<> readableOn(int fd, std::thread::id& thread, std::atomic_bool& done) {
+    co_await Async::readable(fd);
+    thread = std::this_thread::get_id();
+    done = true;
+}
+
+TEST_CASE("Submitting from other threads") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+
+    // The thread has no event loop, so the operation is handed to the main thread's loop
+    std::thread::id thread;
+    std::atomic_bool done = false;
+    std::thread submitter{ [&] { spawn(readableOn(fds[0], thread, done)); } };
+    submitter.join();
+
+    REQUIRE(write(fds[1], "a", 1) == 1);
+    while (!done) Async::handleEvents();
+    CHECK(thread == std::this_thread::get_id());
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// Receives a byte from a socket through the event loop of an executor, then returns the number of bytes received.
+LazyTask<int> receiveOn(Async::Executor executor, int fd) {
+    FrameCounter counter;
+    std::string data(1, 0);
+
+    auto result = co_await Async::run([&](Async::CompletionResult& result) {
+        Async::submit(executor, Async::Receive{ { fd, &result }, data });
+    });
+    co_return result.res;
+}
+
+TEST_CASE("Canceling operations on other executors") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    // Executor of a thread without an event loop, so its operations are handed to the main thread's loop
+    std::thread thread{ [] {} };
+    Async::Executor other{ thread.get_id() };
+    thread.join();
+
+    SECTION("Receives handed to another executor are canceled") {
+        CancelSource source;
+        bool done = false;
+        std::optional<int> result = 0;
+        auto canceled = [&]() -> Task<> {
+            result = co_await withCancellation(source.getToken(), receiveOn(other, fds[0]));
+            done = true;
+        };
+
+        auto canceledTask = canceled();
+        Async::handleEvents(false);
+        source.cancel();
+        while (!done) Async::handleEvents();
+
+        CHECK_FALSE(result);
+        CHECK(FrameCounter::alive == 0);
+
+        // The canceled receive does not take the next byte
+        REQUIRE(write(fds[1], "a", 1) == 1);
+        runSync([&]() -> Task<> {
+            int received = co_await receiveOn(other, fds[0]);
+            CHECK(received == 1);
+        });
+    }
+
+    SECTION("Cancelable operations stay on the awaiting thread") {
+        // The thread has no event loop, so the receive would be handled by the main thread's loop, where the token
+        // could not safely cancel it
+        bool rejected = false;
+        std::thread awaiting{ [&] {
+            CancelSource source;
+            auto receive = [&]() -> Task<> {
+                try {
+                    co_await withCancellation(source.getToken(), receiveOn(Async::getCurrentExecutor(), fds[0]));
+                } catch (const std::invalid_argument&) {
+                    rejected = true;
+                }
+            };
+            receive();
+        } };
+        awaiting.join();
+
+        CHECK(rejected);
+        CHECK(FrameCounter::alive == 0);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
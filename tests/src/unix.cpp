@@ -0,0 +1,40 @@
+// Copyright 2021-2025 Aidan Sun and the WhaleConnect contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "helpers/testio.hpp"
+#include "net/enums.hpp"
+#include "sockets/clientsocket.hpp"
+#include "utils/settingsparser.hpp"
+
+// Unix domain sockets are not supported on Windows
+#if !OS_WINDOWS
+TEST_CASE("I/O (Unix domain sockets)") {
+    SettingsParser parser;
+    parser.load(SETTINGS_FILE);
+
+    const auto streamPath = parser.get<std::string>("unix", "streamPath");
+
+    // Sequenced-packet sockets are only supported on Linux
+#if OS_LINUX
+    const auto seqPacketPath = parser.get<std::string>("unix", "seqPacketPath");
+#endif
+
+    using enum ConnectionType;
+
+    SECTION("Stream") {
+        ClientSocketUnix s;
+        testIOClient(s, { UnixStream, "", streamPath, 0 });
+    }
+
+#if OS_LINUX
+    SECTION("Sequenced packet") {
+        ClientSocketUnix s;
+        testIOClient(s, { UnixSeqPacket, "", seqPacketPath, 0 });
+    }
+#endif
+}
+#endif
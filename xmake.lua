@@ -99,8 +99,8 @@ target("core")
     add_rules("swift-deps")
 
     add_files(
-        "src/net/netutils.cpp",
-        "src/os/async.cpp", "src/os/error.cpp",
+        "src/net/netutils.cpp", "src/net/relay.cpp",
+        "src/os/async.cpp", "src/os/error.cpp", "src/os/file.cpp",
         "src/sockets/delegates/secure/*.cpp",
         "src/utils/*.cpp"
     )
@@ -116,6 +116,7 @@ target("core")
     elseif is_plat("macosx") then
         add_files(
             "src/net/btutils.macos.cpp",
+            "src/net/unixutils.cpp",
             "src/os/async.macos.cpp",
             "src/os/bluetooth.cpp",
             "src/sockets/delegates/macos/*.cpp"
@@ -123,7 +124,11 @@ target("core")
     elseif is_plat("linux") then
         add_files(
             "src/net/btutils.linux.cpp",
+            "src/net/capture.linux.cpp",
+            "src/net/unixutils.cpp",
+            "src/os/async.epoll.cpp",
             "src/os/async.linux.cpp",
+            "src/os/splice.linux.cpp",
             "src/sockets/delegates/linux/*.cpp"
         )
     end